@@ -12,16 +12,64 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cassert>
+#include <future>  // NOLINT
 #include <list>
+#include <new>
 #include <unordered_map>
+#include <vector>
+
+#include "common/logger.h"
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new ClockReplacer(pool_size);
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * Maps at least *size bytes of zeroed memory aligned to PAGE_SIZE for the frames of a buffer pool.
+ * @param[in,out] size the requested size, set to the size of the mapping
+ * @param use_huge_pages true to try reserved huge pages first, then transparent huge pages
+ * @return the mapping
+ */
+char *MapFrames(size_t *size, bool use_huge_pages) {
+  if (use_huge_pages) {
+    size_t huge_size = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *frames = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (frames != MAP_FAILED) {
+      *size = huge_size;
+      return static_cast<char *>(frames);
+    }
+    LOG_DEBUG("no reserved huge pages available, using transparent huge pages");
+  }
+  void *frames = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (frames == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  if (use_huge_pages) {
+    madvise(frames, *size, MADV_HUGEPAGE);
+  }
+  return static_cast<char *>(frames);
+}
+
+}  // namespace
+
+BufferPoolManager::Partition::Partition(Page *pages, size_t pool_size, ReplacerType replacer_type,
+                                        size_t replacer_k)
+    : pool_size_(pool_size), pages_(pages) {
+  switch (replacer_type) {
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k);
+      break;
+    case ReplacerType::CLOCK:
+    default:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -29,57 +77,147 @@ BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager
   }
 }
 
-BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
-  delete replacer_;
-}
+BufferPoolManager::Partition::~Partition() { delete replacer_; }
 
-// Page is always there in memory, just need to change its inner page_id_ & data_ & metadata.
-Page *BufferPoolManager::ReplaceAndUpdate(page_id_t new_page_id, bool new_page,
-                                          std::unique_lock<std::shared_mutex> *u_lock) {
-  assert(!free_list_.empty() || replacer_->Size() != 0);
-  Page *page;
-  frame_id_t index;
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
+bool BufferPoolManager::Partition::FindFreeFrame(frame_id_t *frame_id, bool clean) {
   if (!free_list_.empty()) {
-    index = free_list_.front();
+    *frame_id = free_list_.front();
     free_list_.pop_front();
-    page_table_.emplace(new_page_id, index);
-    page = pages_ + index;
-    page->WLatch();
-    u_lock->unlock();
-    if (!new_page) {
-      disk_manager_->ReadPage(new_page_id, page->data_);
-    }
-  } else {  // replacer
-    [[maybe_unused]] bool victim_res = replacer_->Victim(&index);
-    page = pages_ + index;
-    page_table_.erase(page->page_id_);
-    page_table_.emplace(new_page_id, index);
-    replacer_->Pin(index);
-    page->WLatch();
-    u_lock->unlock();
-    // 2.     If R is dirty, write it back to the disk.
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
+    return true;
+  }
+  // Victims that have been pinned again by a hit since they were unpinned are dropped from the replacer here; the
+  // thread holding the pin puts them back when it unpins. Dirty victims that are skipped go back right away.
+  std::vector<frame_id_t> dirty_frames;
+  bool found = false;
+  while (!found && replacer_->Victim(frame_id)) {
+    if (pages_[*frame_id].pin_count_ != 0) {
+      continue;
     }
-    if (!new_page) {
-      disk_manager_->ReadPage(new_page_id, page->data_);
-    } else {
-      // zero out memory
-      page->ResetMemory();
+    if (clean && pages_[*frame_id].is_dirty_) {
+      dirty_frames.emplace_back(*frame_id);
+      continue;
     }
+    found = true;
+  }
+  for (frame_id_t dirty_frame : dirty_frames) {
+    replacer_->Unpin(dirty_frame);
+  }
+  return found;
+}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     size_t num_instances, ReplacerType replacer_type, size_t replacer_k,
+                                     bool use_huge_pages)
+    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+  // We allocate a consecutive memory space for the buffer pool, the page data in one aligned mapping.
+  frames_size_ = pool_size_ * PAGE_SIZE;
+  frames_ = MapFrames(&frames_size_, use_huge_pages);
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < pool_size_; i++) {
+    new (pages_ + i) Page(frames_ + i * PAGE_SIZE);
   }
-  // 4.     Update P's metadata,
+
+  // Split the frames as evenly as possible, every partition gets at least one frame.
+  num_instances = std::max<size_t>(1, std::min(num_instances, pool_size_));
+  size_t offset = 0;
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t part_size = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+    partitions_.emplace_back(std::make_unique<Partition>(pages_ + offset, part_size, replacer_type, replacer_k));
+    offset += part_size;
+  }
+}
+
+BufferPoolManager::~BufferPoolManager() {
+  StopPrefetcher();
+  StopBackgroundWriter();
+  partitions_.clear();
+  for (size_t i = 0; i < pool_size_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
+  munmap(frames_, frames_size_);
+}
+
+// Page is always there in memory, just need to change its inner page_id_ & data_ & metadata.
+Page *BufferPoolManager::InstallPage(Partition *part, frame_id_t index, page_id_t new_page_id, bool new_page,
+                                     std::unique_lock<std::shared_mutex> *u_lock, page_id_t *dirty_page_id) {
+  Page *page = part->pages_ + index;
+  const page_id_t old_page_id = page->page_id_;
+  *dirty_page_id = old_page_id != INVALID_PAGE_ID && page->is_dirty_ ? old_page_id : INVALID_PAGE_ID;
+  // 3.     Delete R from the page table and insert P.
+  if (old_page_id != INVALID_PAGE_ID) {
+    part->page_table_.erase(old_page_id);
+  }
+  part->page_table_.emplace(new_page_id, index);
+  part->replacer_->Reset(index);
+  // 4.     Update P's metadata. This happens under the partition latch, so that a concurrent fetch of the same page
+  //        pins on top of our pin; the page latch keeps it away from the content until the I/O is done.
+  page->WLatch();
   page->page_id_ = new_page_id;
   page->pin_count_ = 1;
   page->is_dirty_ = new_page;
+  u_lock->unlock();
+  return page;
+}
+
+Page *BufferPoolManager::ReplaceAndUpdate(Partition *part, frame_id_t index, page_id_t new_page_id, bool new_page,
+                                          std::unique_lock<std::shared_mutex> *u_lock) {
+  page_id_t dirty_page_id;
+  Page *page = InstallPage(part, index, new_page_id, new_page, u_lock, &dirty_page_id);
+  // 2.     If R is dirty, write it back to the disk.
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(dirty_page_id, page->data_);
+    num_foreground_writes_++;
+    // The background writer is falling behind, don't let it sleep out its interval.
+    bg_writer_cv_.notify_one();
+  }
+  if (!new_page) {
+    disk_manager_->ReadPage(new_page_id, page->data_);
+  } else {
+    // zero out memory
+    page->ResetMemory();
+  }
   page->WUnlatch();
   return page;
 }
 
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+bool BufferPoolManager::FindRingFrame(Partition *part, page_id_t page_id, BufferRing *ring, frame_id_t *frame_id,
+                                      bool clean) {
+  if (ring->slots_.size() != partitions_.size()) {
+    ring->slots_.assign(partitions_.size(), {});
+    ring->cursors_.assign(partitions_.size(), 0);
+  }
+  // Every partition gets its share of the ring, the scan touches all of them in turn.
+  const size_t capacity = std::max<size_t>(1, ring->ring_size_ / partitions_.size());
+  auto &slots = ring->slots_[page_id % partitions_.size()];
+  auto &cursor = ring->cursors_[page_id % partitions_.size()];
+
+  if (slots.size() < capacity) {
+    if (!part->FindFreeFrame(frame_id, clean)) {
+      return false;
+    }
+    slots.push_back({*frame_id, page_id});
+    return true;
+  }
+
+  auto &slot = slots[cursor];
+  cursor = (cursor + 1) % slots.size();
+  // The pin count cannot leave zero while we hold the latch exclusively. If the frame is still unpinned and holds the
+  // page we read into it, take it out of the replacer and reuse it; otherwise someone else is using it now, leave it
+  // to them and continue with a fresh frame in this slot.
+  auto *page = part->pages_ + slot.frame_id_;
+  if (page->page_id_ == slot.page_id_ && page->pin_count_ == 0 && !(clean && page->is_dirty_)) {
+    part->replacer_->Pin(slot.frame_id_);
+    ring->num_recycled_++;
+    *frame_id = slot.frame_id_;
+  } else if (!part->FindFreeFrame(frame_id, clean)) {
+    return false;
+  }
+  slot = {*frame_id, page_id};
+  return true;
+}
+
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id, BufferRing *ring) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -87,54 +225,71 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::unique_lock lock(latch_);
-  auto iter = page_table_.find(page_id);
-
-  // If P exists, pin it and return it immediately.
-  if (iter != page_table_.end()) {
-    // find frame index by page_id
-    auto index = iter->second;
-    auto *page = pages_ + index;
-    page->pin_count_++;
-    if (page->pin_count_ > 0) {
-      replacer_->Pin(index);
+  auto *part = GetPartition(page_id);
+  {
+    // If P exists, pin it and return it immediately. Readers of the page table do not block each other.
+    std::shared_lock s_lock(part->latch_);
+    auto iter = part->page_table_.find(page_id);
+    if (iter != part->page_table_.end()) {
+      auto *page = part->pages_ + iter->second;
+      page->pin_count_++;
+      return page;
     }
+  }
+
+  std::unique_lock lock(part->latch_);
+  // Someone else may have loaded P while we were not holding the latch.
+  auto iter = part->page_table_.find(page_id);
+  if (iter != part->page_table_.end()) {
+    auto *page = part->pages_ + iter->second;
+    page->pin_count_++;
     return page;
   }
 
-  if (free_list_.empty() && replacer_->Size() == 0) {
+  frame_id_t index;
+  if (ring != nullptr ? !FindRingFrame(part, page_id, ring, &index) : !part->FindFreeFrame(&index)) {
     return nullptr;
   }
-  return ReplaceAndUpdate(page_id, false, &lock);
+  return ReplaceAndUpdate(part, index, page_id, false, &lock);
 }
 
 // * @param is_dirty true if the page should be marked as dirty, false otherwise
 // * @return false if the page pin count is <= 0 before this call, true otherwise
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
-  std::unique_lock u_lock(latch_);
-  const auto got = page_table_.find(page_id);
-  auto frame_index = got->second;
-  auto* page = pages_ + frame_index;
-  if (page->pin_count_ <= 0) {
+  auto *part = GetPartition(page_id);
+  std::shared_lock s_lock(part->latch_);
+  const auto got = part->page_table_.find(page_id);
+  if (got == part->page_table_.end()) {
     return false;
   }
-  if (--page->pin_count_ == 0) {
-    replacer_->Unpin(got->second);
+  auto frame_index = got->second;
+  auto *page = part->pages_ + frame_index;
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1) {
+    part->replacer_->Unpin(frame_index);
   }
-  page->is_dirty_ |= is_dirty;
   return true;
 }
 
 // Flushes the target page to disk.
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  std::unique_lock lock(latch_);
-  const auto& got = page_table_.find(page_id);
-  if (got == page_table_.end()) {
+  auto *part = GetPartition(page_id);
+  std::unique_lock lock(part->latch_);
+  const auto &got = part->page_table_.find(page_id);
+  if (got == part->page_table_.end()) {
     lock.unlock();
     return false;
   }
-  auto *page = pages_ + got->second;
+  auto *page = part->pages_ + got->second;
   page->WLatch();
   lock.unlock();
   if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
@@ -152,14 +307,62 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::unique_lock lock(latch_);
-  if (free_list_.empty() && replacer_->Size() == 0) {
-    *page_id = INVALID_PAGE_ID;
+  *page_id = INVALID_PAGE_ID;
+  if (partitions_.size() == 1) {
+    auto *part = partitions_.front().get();
+    std::unique_lock lock(part->latch_);
+    page_id_t id = disk_manager_->AllocatePage();
+    Page *page = CreatePage(part, id, &lock);
+    if (page == nullptr) {
+      disk_manager_->DeallocatePage(id);
+    } else {
+      *page_id = id;
+    }
+    return page;
+  }
+
+  // The allocated page id decides the partition of the new page. If that partition is fully pinned, keep allocating
+  // (consecutive ids land on the other partitions) and give the rejected ids back to the disk manager afterwards.
+  Page *page = nullptr;
+  std::vector<page_id_t> rejected;
+  for (size_t attempt = 0; attempt < partitions_.size() && page == nullptr; attempt++) {
+    page_id_t id = disk_manager_->AllocatePage();
+    auto *part = GetPartition(id);
+    std::unique_lock lock(part->latch_);
+    page = CreatePage(part, id, &lock);
+    if (page == nullptr) {
+      rejected.emplace_back(id);
+    } else {
+      *page_id = id;
+    }
+  }
+  for (auto id : rejected) {
+    disk_manager_->DeallocatePage(id);
+  }
+  return page;
+}
+
+Page *BufferPoolManager::CreatePage(Partition *part, page_id_t new_page_id,
+                                    std::unique_lock<std::shared_mutex> *u_lock) {
+  const auto &got = part->page_table_.find(new_page_id);
+  if (got != part->page_table_.end()) {
+    // The id was freed and reused, and a scan's readahead loaded its stale content in between. Take that frame over;
+    // the write latch waits for the prefetch read to finish.
+    auto *page = part->pages_ + got->second;
+    page->pin_count_++;
+    part->replacer_->Pin(got->second);
+    u_lock->unlock();
+    page->WLatch();
+    page->ResetMemory();
+    page->is_dirty_ = true;
+    page->WUnlatch();
+    return page;
+  }
+  frame_id_t index;
+  if (!part->FindFreeFrame(&index)) {
     return nullptr;
   }
-  page_id_t id = disk_manager_->AllocatePage();
-  *page_id = id;
-  return ReplaceAndUpdate(id, true, &lock);
+  return ReplaceAndUpdate(part, index, new_page_id, true, u_lock);
 }
 
 bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
@@ -168,15 +371,16 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::unique_lock u_lock(latch_);
-  const auto &got = page_table_.find(page_id);
-  if (got == page_table_.end()) {
+  auto *part = GetPartition(page_id);
+  std::unique_lock u_lock(part->latch_);
+  const auto &got = part->page_table_.find(page_id);
+  if (got == part->page_table_.end()) {
     u_lock.unlock();
     disk_manager_->DeallocatePage(page_id);
     return true;
   }
   auto index = got->second;
-  auto* page = pages_ + index;
+  auto *page = part->pages_ + index;
   page->WLatch();
   // 2. If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   if (page->pin_count_ > 0) {
@@ -185,9 +389,9 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
     return false;
   }
   // 3.   Otherwise, P can be deleted. Remove P from the page table,
-  replacer_->Pin(index);
-  page_table_.erase(got->first);
-  free_list_.emplace_back(index);
+  part->replacer_->Pin(index);
+  part->page_table_.erase(got);
+  part->free_list_.emplace_back(index);
   u_lock.unlock();
 
   // reset its metadata and return it to the free list.
@@ -197,17 +401,223 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   page->is_dirty_ = false;
   page->WUnlatch();
 
-  return false;
+  return true;
 }
 
 // Flush all pages to disk. Actually only need to flush valid dirty pages.
 void BufferPoolManager::FlushAllPagesImpl() {
-  std::unique_lock lock(latch_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    auto* page = pages_ + i;
-    if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
-      page->is_dirty_ = false;
+  for (auto &part : partitions_) {
+    std::unique_lock lock(part->latch_);
+    // Write all the dirty pages of the partition at once instead of one after the other.
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < part->pool_size_; i++) {
+      auto *page = part->pages_ + i;
+      if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
+        futures.emplace_back(disk_manager_->WritePageAsync(page->page_id_, page->data_));
+        page->is_dirty_ = false;
+      }
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+  }
+  // This is the point at which everything written so far has to be durable.
+  disk_manager_->SyncData();
+}
+
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids, BufferRing *ring) {
+  std::vector<Page *> loads;
+  if (ring != nullptr) {
+    // The ring belongs to the calling thread, so its frames are picked here and only the I/O is left to the thread.
+    loads = InstallPrefetch(page_ids, ring);
+    if (loads.empty()) {
+      return;
+    }
+  }
+  std::scoped_lock lock(prefetch_latch_);
+  if (!prefetch_thread_.joinable()) {
+    prefetch_running_ = true;
+    prefetch_thread_ = std::thread([this] {
+      // Every frame of a batch stays pinned until its read is done, keep enough frames for everyone else.
+      const size_t max_batch_size = std::max<size_t>(1, pool_size_ / 4);
+      std::unique_lock lock(prefetch_latch_);
+      while (true) {
+        prefetch_cv_.wait(lock, [this] {
+          return !prefetch_running_ || !prefetch_queue_.empty() || !prefetch_loads_.empty();
+        });
+        // Installed pages are latched and pinned, they are loaded even on shutdown.
+        if (!prefetch_loads_.empty()) {
+          auto loads = std::move(prefetch_loads_.front());
+          prefetch_loads_.pop_front();
+          lock.unlock();
+          LoadPrefetch(loads);
+          lock.lock();
+          continue;
+        }
+        if (!prefetch_running_) {
+          return;
+        }
+        std::vector<page_id_t> batch;
+        while (!prefetch_queue_.empty() && batch.size() < max_batch_size) {
+          batch.emplace_back(prefetch_queue_.front());
+          prefetch_queue_.pop_front();
+        }
+        lock.unlock();
+        LoadPrefetch(InstallPrefetch(batch, nullptr));
+        lock.lock();
+      }
+    });
+  }
+  if (ring != nullptr) {
+    prefetch_loads_.emplace_back(std::move(loads));
+  } else {
+    for (auto page_id : page_ids) {
+      // Whatever does not fit into the pool would only evict the pages prefetched before it.
+      if (prefetch_queue_.size() < pool_size_) {
+        prefetch_queue_.emplace_back(page_id);
+      }
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::StopPrefetcher() {
+  {
+    std::scoped_lock lock(prefetch_latch_);
+    prefetch_running_ = false;
+    prefetch_queue_.clear();
+  }
+  prefetch_cv_.notify_one();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
+}
+
+std::vector<Page *> BufferPoolManager::InstallPrefetch(const std::vector<page_id_t> &page_ids, BufferRing *ring) {
+  // A page that was allocated but never written may be about to be created by NewPage, loading it would race with
+  // that. Reading it, or a free page, would not return anything useful anyway.
+  const page_id_t num_pages_on_disk = disk_manager_->GetNumPages();
+  std::vector<Page *> loads;
+  for (auto page_id : page_ids) {
+    if (page_id < 0 || page_id >= num_pages_on_disk || disk_manager_->IsPageFree(page_id)) {
+      continue;
+    }
+    auto *part = GetPartition(page_id);
+    // Once we hold the write latch of a page of the batch, we must not wait for a partition latch: FlushPage and
+    // DeletePage hold the partition latch while they wait for a page latch. Leave the rest for the next batch.
+    std::unique_lock lock(part->latch_, std::defer_lock);
+    if (loads.empty()) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      break;
+    }
+    // Only clean victims: once InstallPage drops a victim from the page table, a fetch of it reads it from disk, and
+    // the write of a dirty one could still be queued behind the batch.
+    frame_id_t index;
+    if (part->page_table_.count(page_id) != 0 ||
+        (ring != nullptr ? !FindRingFrame(part, page_id, ring, &index, true) : !part->FindFreeFrame(&index, true))) {
+      continue;
+    }
+    [[maybe_unused]] page_id_t dirty_page_id;
+    loads.emplace_back(InstallPage(part, index, page_id, false, &lock, &dirty_page_id));
+    BUSTUB_ASSERT(dirty_page_id == INVALID_PAGE_ID, "A prefetch must not evict a dirty page.");
+  }
+  return loads;
+}
+
+void BufferPoolManager::LoadPrefetch(const std::vector<Page *> &loads) {
+  // Keep all the reads in flight at once.
+  std::vector<std::future<void>> futures;
+  for (auto *page : loads) {
+    futures.emplace_back(disk_manager_->ReadPageAsync(page->page_id_, page->data_));
+  }
+  for (auto &future : futures) {
+    future.wait();
+  }
+  for (auto *page : loads) {
+    page_id_t page_id = page->page_id_;
+    page->WUnlatch();
+    num_prefetched_++;
+    UnpinPageImpl(page_id, false);
+  }
+}
+
+void BufferPoolManager::StartBackgroundWriter(size_t num_clean_frames) {
+  StopBackgroundWriter();
+  bg_writer_cursors_.assign(partitions_.size(), 0);
+  // Round up, so that every partition has at least one clean frame to offer if asked for any.
+  const size_t clean_target = (num_clean_frames + partitions_.size() - 1) / partitions_.size();
+  bg_writer_running_ = true;
+  bg_writer_thread_ = std::thread([this, clean_target] {
+    std::unique_lock lock(bg_writer_latch_);
+    while (bg_writer_running_) {
+      lock.unlock();
+      BackgroundWriteRound(clean_target);
+      lock.lock();
+      bg_writer_cv_.wait_for(lock, bg_writer_interval);
+    }
+  });
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::scoped_lock lock(bg_writer_latch_);
+    bg_writer_running_ = false;
+  }
+  bg_writer_cv_.notify_one();
+  if (bg_writer_thread_.joinable()) {
+    bg_writer_thread_.join();
+  }
+}
+
+void BufferPoolManager::BackgroundWriteRound(size_t clean_target) {
+  const bool check_wal = enable_logging && log_manager_ != nullptr;
+  for (size_t i = 0; i < partitions_.size(); i++) {
+    auto *part = partitions_[i].get();
+    // In shared mode, the latch keeps every frame holding its page while hits go on as usual. Only misses of this
+    // partition wait for the writes of this round.
+    std::shared_lock s_lock(part->latch_);
+    size_t num_clean = part->free_list_.size();
+    for (size_t j = 0; j < part->pool_size_; j++) {
+      auto *page = part->pages_ + j;
+      if (page->page_id_ != INVALID_PAGE_ID && page->pin_count_ == 0 && !page->is_dirty_) {
+        num_clean++;
+      }
+    }
+
+    std::vector<Page *> batch;
+    size_t &cursor = bg_writer_cursors_[i];
+    for (size_t scanned = 0; scanned < part->pool_size_ && num_clean < clean_target; scanned++) {
+      auto *page = part->pages_ + cursor;
+      cursor = (cursor + 1) % part->pool_size_;
+      if (page->page_id_ == INVALID_PAGE_ID || page->pin_count_ != 0 || !page->is_dirty_) {
+        continue;
+      }
+      // Never wait for a page latch here: its holder may be about to miss on this partition, which needs the
+      // partition latch exclusively. A page somebody is latching is not a good candidate anyway.
+      if (!page->TryRLatch()) {
+        continue;
+      }
+      // Write-ahead logging: the log records up to the page LSN have to be on disk before the page is.
+      if (page->pin_count_ == 0 && page->is_dirty_ &&
+          (!check_wal || page->GetLSN() <= log_manager_->GetPersistentLSN())) {
+        page->is_dirty_ = false;
+        batch.emplace_back(page);
+        num_clean++;
+      } else {
+        page->RUnlatch();
+      }
+    }
+
+    // The pages of the batch stay read latched until all their writes are done.
+    std::vector<std::future<void>> futures;
+    for (auto *page : batch) {
+      futures.emplace_back(disk_manager_->WritePageAsync(page->page_id_, page->data_));
+      num_background_writes_++;
+    }
+    for (size_t j = 0; j < batch.size(); j++) {
+      futures[j].wait();
+      batch[j]->RUnlatch();
     }
   }
 }
@@ -12,67 +12,58 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <cassert>
 #include <iostream>
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {
-  clock.reserve(num_pages);
-  for (size_t i = 0; i < num_pages; i++) {
-    clock.emplace_back(NOT_EXISTS, NO_REF);
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_frames(num_pages), clock(std::make_unique<std::atomic<uint8_t>[]>(num_pages)) {
+  for (size_t i = 0; i < num_frames; i++) {
+    clock[i] = 0;
   }
 }
 
 ClockReplacer::~ClockReplacer() = default;
 
 bool ClockReplacer::Victim(frame_id_t *frame_id) {
-  std::lock_guard<std::shared_mutex> lock(latch);
-  if (size == 0) {
-    return false;
-  }
-  while (true) {
-    assert(hand < clock.size());
-    auto &entry = clock[hand];  // without &, it is a copy
-    if (entry.first) {          // exist
-      if (entry.second) {       // pinned
-        entry.second = NO_REF;
-      } else {
+  std::lock_guard<std::mutex> lock(latch);
+  while (size != 0) {
+    assert(hand < num_frames);
+    auto &entry = clock[hand];
+    uint8_t state = entry;
+    if ((state & EXISTS) != 0) {
+      if ((state & REF) != 0) {
+        entry &= static_cast<uint8_t>(~REF);
+      } else if (entry.compare_exchange_strong(state, 0)) {
         // find a victim
         *frame_id = static_cast<frame_id_t>(hand);
-        entry.first = NOT_EXISTS;
         size--;
         return true;
+      } else {
+        // unpinned again in the meantime, look at this frame once more
+        continue;
       }
     }
-    hand = (hand + 1) % clock.size();
+    hand = (hand + 1) % num_frames;
   }
+  return false;
 }
 
 void ClockReplacer::Pin(frame_id_t frame_id) {
-  std::lock_guard<std::shared_mutex> lock(latch);
-  assert(static_cast<size_t>(frame_id) <= clock.size());
-  auto &pair = clock[frame_id];
-  if (pair.first) {
-    pair.first = NOT_EXISTS;
+  assert(static_cast<size_t>(frame_id) < num_frames);
+  if ((clock[frame_id].exchange(0) & EXISTS) != 0) {
     size--;
   }
-  pair.second = NO_REF;
 }
 
 void ClockReplacer::Unpin(frame_id_t frame_id) {
-  std::lock_guard<std::shared_mutex> lock(latch);
-  assert(static_cast<size_t>(frame_id) <= clock.size());
-  auto &pair = clock[frame_id];
-  if (!pair.first) {
-    pair.first = EXISTS;
+  assert(static_cast<size_t>(frame_id) < num_frames);
+  if ((clock[frame_id].fetch_or(EXISTS | REF) & EXISTS) == 0) {
     size++;
   }
-  pair.second = REF;
 }
 
-size_t ClockReplacer::Size() {
-  std::shared_lock<std::shared_mutex> shared_lock(latch);
-  return size;
-}
+size_t ClockReplacer::Size() { return size; }
 
 }  // namespace bustub
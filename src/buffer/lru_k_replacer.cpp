@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <cassert>
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : k_(k == 0 ? 1 : k), history_(num_pages), evictable_(num_pages, false) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+size_t LRUKReplacer::OrderKey(frame_id_t frame_id) const {
+  const auto &history = history_[frame_id];
+  // Young frames are ordered by their last access, old frames by their k-th most recent access.
+  return history.size() < k_ ? history.back() : history.front();
+}
+
+void LRUKReplacer::AddEvictable(frame_id_t frame_id) {
+  auto &set = history_[frame_id].size() < k_ ? young_ : old_;
+  set.emplace(OrderKey(frame_id), frame_id);
+  evictable_[frame_id] = true;
+}
+
+void LRUKReplacer::RemoveEvictable(frame_id_t frame_id) {
+  auto &set = history_[frame_id].size() < k_ ? young_ : old_;
+  set.erase({OrderKey(frame_id), frame_id});
+  evictable_[frame_id] = false;
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto &set = young_.empty() ? old_ : young_;
+  if (set.empty()) {
+    return false;
+  }
+  *frame_id = set.begin()->second;
+  set.erase(set.begin());
+  evictable_[*frame_id] = false;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  assert(static_cast<size_t>(frame_id) < history_.size());
+  if (evictable_[frame_id]) {
+    RemoveEvictable(frame_id);
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  assert(static_cast<size_t>(frame_id) < history_.size());
+  if (evictable_[frame_id]) {
+    RemoveEvictable(frame_id);
+  }
+  auto &history = history_[frame_id];
+  history.emplace_back(current_timestamp_++);
+  if (history.size() > k_) {
+    history.pop_front();
+  }
+  AddEvictable(frame_id);
+}
+
+void LRUKReplacer::Reset(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  assert(static_cast<size_t>(frame_id) < history_.size());
+  if (evictable_[frame_id]) {
+    RemoveEvictable(frame_id);
+  }
+  history_[frame_id].clear();
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return young_.size() + old_.size();
+}
+
+}  // namespace bustub
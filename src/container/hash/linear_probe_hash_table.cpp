@@ -10,8 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -24,44 +26,189 @@
 #include "storage/table/tmp_tuple.h"
 
 namespace bustub {
+
+namespace {
+// The stripe of the counts of running operations a thread uses.
+size_t EpochSlotIndex() {
+  thread_local const size_t index = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return index;
+}
+}  // namespace
+
 // Note that each page can store multiple (BLOCK_ARRAY_SIZE) blocks, so the hash table needs to find both the
 // target page & target slot/block inside the target page, in order to retrieve/add/update the KV pair.
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : page_number((num_buckets - 1) / BLOCK_ARRAY_SIZE_PRO_PAGE + 1), buffer_pool_manager_(buffer_pool_manager),
-      comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  // get a header page from the BufferPoolManager
+                                      HashFunction<KeyType> hash_fn, double max_load_factor, bool fingerprints)
+    : max_load_factor_(max_load_factor),
+      fingerprints_(fingerprints),
+      slots_per_page_(fingerprints ? HashTableBlockPage<KeyType, ValueType, KeyComparator>::FINGERPRINT_ARRAY_SIZE
+                                   : BLOCK_ARRAY_SIZE),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
+  BUSTUB_ASSERT(max_load_factor > 0 && max_load_factor <= 1, "The maximum load factor must be in (0, 1].");
+  // allocate block pages for the bucket number
+  states_[0].buckets_ = AllocateBuckets(num_buckets);
+
+  // get a header page from the BufferPoolManager, and add the block page ids to it
   auto bpm_head_page = buffer_pool_manager_->NewPage(&header_page_id_);
   bpm_head_page->WLatch();
   auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
   ht_header_page->SetSize(num_buckets);
-  size_cache = num_buckets;
-  BLOCK_ARRAY_SIZE_LAST_PAGE = num_buckets - BLOCK_ARRAY_SIZE_PRO_PAGE * (page_number - 1);
+  ht_header_page->SetOldSize(0);
+  ht_header_page->SetMovedBuckets(0);
+  ht_header_page->SetNumPairs(0);
+  ht_header_page->SetNumTombstones(0);
   ht_header_page->SetPageId(header_page_id_);
   ht_header_page->SetLSN(0);
+  for (page_id_t page_id : states_[0].buckets_.page_ids_) {
+    ht_header_page->AddBlockPageId(page_id);
+  }
   bpm_head_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(header_page_id_, true);
+}
 
-  // allocate block pages for the bucket number
-  page_ids_cache.reserve(page_number);
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::LinearProbeHashTable(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                                      page_id_t header_page_id, HashFunction<KeyType> hash_fn,
+                                      double max_load_factor, bool fingerprints)
+    : header_page_id_(header_page_id),
+      max_load_factor_(max_load_factor),
+      fingerprints_(fingerprints),
+      slots_per_page_(fingerprints ? HashTableBlockPage<KeyType, ValueType, KeyComparator>::FINGERPRINT_ARRAY_SIZE
+                                   : BLOCK_ARRAY_SIZE),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
+  BUSTUB_ASSERT(max_load_factor > 0 && max_load_factor <= 1, "The maximum load factor must be in (0, 1].");
+  auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
+  bpm_head_page->RLatch();
+  auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
+  TableState &state = states_[0];
+  state.buckets_.size_ = ht_header_page->GetSize();
+  state.old_buckets_.size_ = ht_header_page->GetOldSize();
+  // The block pages of the old buckets come first.
+  const size_t old_page_number =
+      state.old_buckets_.size_ == 0 ? 0 : (state.old_buckets_.size_ - 1) / slots_per_page_ + 1;
+  for (size_t i = 0; i < ht_header_page->NumBlocks(); i++) {
+    BucketArray &buckets = i < old_page_number ? state.old_buckets_ : state.buckets_;
+    buckets.page_ids_.emplace_back(ht_header_page->GetBlockPageId(i));
+  }
+  num_pairs_ = ht_header_page->GetNumPairs();
+  num_tombstones_ = ht_header_page->GetNumTombstones();
+  bpm_head_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+
+  // Finish the resize that was under way. Its moved buckets are no longer readable in the old array, moving them
+  // again skips them.
+  if (old_page_number != 0) {
+    std::scoped_lock resize_latch(resize_latch_);
+    resizing_ = true;
+    moving_ = true;
+    FinishResize();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_TYPE::Enter() {
+  EpochSlot &slot = epoch_slots_[EpochSlotIndex() % NUM_EPOCH_SLOTS];
+  while (true) {
+    const uint64_t version = version_;
+    slot.active_[version % 2]++;
+    // A resize that published the next version in the meantime may not have seen this operation.
+    if (version_ == version) {
+      return version;
+    }
+    slot.active_[version % 2]--;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Leave(uint64_t version) {
+  epoch_slots_[EpochSlotIndex() % NUM_EPOCH_SLOTS].active_[version % 2]--;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Publish(TableState state) {
+  // The operations on the version before the current one have all finished, so its state can be replaced.
+  const uint64_t version = version_;
+  states_[(version + 1) % 2] = std::move(state);
+  version_ = version + 1;
+  for (auto &slot : epoch_slots_) {
+    while (slot.active_[version % 2] != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename HASH_TABLE_TYPE::BucketArray HASH_TABLE_TYPE::AllocateBuckets(size_t num_buckets) {
+  BucketArray buckets;
+  buckets.size_ = num_buckets;
+  const size_t page_number = (num_buckets - 1) / slots_per_page_ + 1;
+  buckets.page_ids_.reserve(page_number);
   page_id_t page_id;
   for (size_t i = 0; i < page_number; i++) {
     buffer_pool_manager_->NewPage(&page_id);
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    page_ids_cache.emplace_back(page_id);
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    buckets.page_ids_.emplace_back(page_id);
   }
+  return buckets;
+}
 
-  // add block page id to the header page
-  bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
-  bpm_head_page->WLatch();
-  ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
-  for (size_t i = 0; i < page_number; i++) {
-    ht_header_page->AddBlockPageId(page_ids_cache[i]);
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::Probe(const BucketArray &buckets, uint64_t hash_value, bool exclusive, bool until_free,
+                            bool *tombstone, Visitor &&visit) {
+  const auto page_postion = GetPagePosition(hash_value % buckets.size_);
+  size_t page_index = page_postion.first;
+  slot_offset_t slot_offset = page_postion.second;
+  size_t remaining = buckets.size_;
+  const uint8_t fingerprint = Fingerprint(hash_value);
+  auto latch = [exclusive](Page *bpm_page) { exclusive ? bpm_page->WLatch() : bpm_page->RLatch(); };
+  auto unlatch = [exclusive](Page *bpm_page) { exclusive ? bpm_page->WUnlatch() : bpm_page->RUnlatch(); };
+
+  while (true) {
+    auto bpm_page = buffer_pool_manager_->FetchPage(buckets.page_ids_[page_index]);
+    latch(bpm_page);
+    auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator> *>(bpm_page->GetData());
+    // The walk goes on the buckets of this page in [slot_offset, page_end), and ends at end if it is before page_end.
+    const auto page_end =
+        static_cast<slot_offset_t>(std::min<size_t>(NumSlots(buckets, page_index), slot_offset + remaining));
+    const slot_offset_t end =
+        until_free ? block_page->NextFree(slot_offset, page_end) : block_page->NextUnoccupied(slot_offset, page_end);
+    if (tombstone != nullptr && !*tombstone) {
+      *tombstone = block_page->NextTombstone(slot_offset, end) != end;
+    }
+    bool stopped = false;
+    for (slot_offset_t base = slot_offset; base < end && !stopped; base += 64) {
+      uint64_t bits = block_page->ReadableBits(base, end);
+      if (fingerprints_ && bits != 0) {
+        bits &= block_page->FingerprintBits(base, end, fingerprint);
+      }
+      while (bits != 0 && !stopped) {
+        const auto lead = static_cast<slot_offset_t>(__builtin_clzll(bits));
+        bits &= ~((1ULL << 63) >> lead);
+        stopped = visit(block_page, base + lead);
+      }
+    }
+    const bool ended = !stopped && end != page_end;
+    if (ended) {
+      stopped = visit(block_page, end);
+    }
+    unlatch(bpm_page);
+    buffer_pool_manager_->UnpinPage(buckets.page_ids_[page_index], exclusive && stopped);
+    remaining -= page_end - slot_offset;
+    if (stopped || ended || remaining == 0) {
+      return stopped;
+    }
+    slot_offset = 0;
+    if (++page_index == buckets.page_ids_.size()) {
+      page_index = 0;
+    }
   }
-  bpm_head_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 }
 
 /*****************************************************************************
@@ -70,100 +217,120 @@ HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   const uint64_t hash_value = hash_fn_.GetHash(key);
-  table_latch_.RLock();
-  const size_t hash_position = hash_value % size_cache;
-  const auto page_postion = GetPagePosition(hash_position);
-  const size_t page_index_start = page_postion.first;
-  const slot_offset_t slot_offset_start = page_postion.second;
-  size_t page_index = page_postion.first;
-  slot_offset_t slot_offset = page_postion.second;
-  auto bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-  bpm_page->RLatch();
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-  while (block_page->IsOccupied(slot_offset)) {
-    if (block_page->IsReadable(slot_offset)
-        && comparator_(key, block_page->KeyAt(slot_offset)) == 0) {
-      result->emplace_back(block_page->ValueAt(slot_offset));
-    }
-
-    if (++slot_offset == ((page_index == page_number - 1) ? BLOCK_ARRAY_SIZE_LAST_PAGE : BLOCK_ARRAY_SIZE_PRO_PAGE)) {
-      slot_offset = 0;
-      bpm_page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      if (++page_index == page_number) {
-        page_index = 0;
+  const size_t begin = result->size();
+  size_t old_end = begin;
+  auto collect = [this, &key, result, begin, &old_end](auto *block_page, slot_offset_t slot_offset) {
+    if (block_page->IsReadable(slot_offset) && comparator_(key, block_page->KeyAt(slot_offset)) == 0) {
+      const ValueType value = block_page->ValueAt(slot_offset);
+      // A pair that was moved while the old buckets were probed is found again in the new ones.
+      if (std::find(result->begin() + begin, result->begin() + old_end, value) == result->begin() + old_end) {
+        result->emplace_back(value);
       }
-      bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-      bpm_page->RLatch();
-      block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-    }
-    if (page_index_start == page_index && slot_offset_start == slot_offset) {
-      break;
     }
+    return false;
+  };
+  const uint64_t version = Enter();
+  const TableState &state = states_[version % 2];
+  if (!state.old_buckets_.page_ids_.empty()) {
+    Probe(state.old_buckets_, hash_value, false, false, nullptr, collect);
+    old_end = result->size();
   }
-  bpm_page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-  table_latch_.RUnlock();
-  return !result->empty();
+  Probe(state.buckets_, hash_value, false, false, nullptr, collect);
+  Leave(version);
+  return result->size() > begin;
 }
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Insert_Helper(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  const uint64_t hash_value = hash_fn_.GetHash(key);
-  const size_t hash_position = hash_value % size_cache;
-  const auto page_postion = GetPagePosition(hash_position);
-  const size_t page_index_start = page_postion.first;
-  const slot_offset_t slot_offset_start = page_postion.second;
-  size_t page_index = page_postion.first;
-  slot_offset_t slot_offset = page_postion.second;
-  auto bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-  bpm_page->WLatch();
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-  while (!block_page->Insert(slot_offset, key, value)) {
-    if (block_page->IsReadable(slot_offset)
-        && comparator_(key, block_page->KeyAt(slot_offset)) == 0
-        && value == block_page->ValueAt(slot_offset)) {
-      bpm_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      return false;
+bool HASH_TABLE_TYPE::InsertPair(const BucketArray &buckets, uint64_t hash_value, const KeyType &key,
+                                 const ValueType &value, bool *inserted) {
+  // duplicate values for the same key are not allowed, so the whole probe sequence is checked. Without a tombstone
+  // in it, the pair goes to the bucket that ends it.
+  bool duplicate = false;
+  bool tombstone = false;
+  auto check = [&](auto *block_page, slot_offset_t slot_offset) {
+    if (block_page->IsReadable(slot_offset)) {
+      duplicate = comparator_(key, block_page->KeyAt(slot_offset)) == 0 && value == block_page->ValueAt(slot_offset);
+      return duplicate;
     }
-
-    if (++slot_offset == ((page_index == page_number - 1) ? BLOCK_ARRAY_SIZE_LAST_PAGE : BLOCK_ARRAY_SIZE_PRO_PAGE)) {
-      slot_offset = 0;
-      bpm_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      if (++page_index == page_number) {
-        page_index = 0;
-      }
-      bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-      bpm_page->WLatch();
-      block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-    }
-    if (page_index_start == page_index && slot_offset_start == slot_offset) {
-      bpm_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      throw hash_table_full_error{};
+    *inserted = !tombstone && block_page->Insert(slot_offset, key, value);
+    if (*inserted && fingerprints_) {
+      block_page->SetFingerprint(slot_offset, Fingerprint(hash_value));
     }
+    return true;
+  };
+  const bool ended = Probe(buckets, hash_value, true, false, &tombstone, check);
+  if (duplicate || *inserted) {
+    return true;
+  }
+  if (!tombstone) {
+    return ended;
   }
-  bpm_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], true);
-  return true;
+  // Reuse the first tombstone.
+  return Probe(buckets, hash_value, true, true, nullptr, [&](auto *block_page, slot_offset_t slot_offset) {
+    if (block_page->IsReadable(slot_offset)) {
+      return comparator_(key, block_page->KeyAt(slot_offset)) == 0 && value == block_page->ValueAt(slot_offset);
+    }
+    num_tombstones_ -= block_page->IsOccupied(slot_offset) ? 1 : 0;
+    *inserted = block_page->Insert(slot_offset, key, value);
+    if (*inserted && fingerprints_) {
+      block_page->SetFingerprint(slot_offset, Fingerprint(hash_value));
+    }
+    return true;
+  });
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  table_latch_.RLock();
-  bool insert_helper_res = false;
-  try {
-    insert_helper_res = Insert_Helper(transaction, key, value);
-  } catch (hash_table_full_error) {
-    table_latch_.RUnlock();
-    throw hash_table_full_error{};
+  const uint64_t hash_value = hash_fn_.GetHash(key);
+  while (true) {
+    const uint64_t version = Enter();
+    const TableState &state = states_[version % 2];
+    const bool moving = !state.old_buckets_.page_ids_.empty();
+    bool moved_last = false;
+    if (moving) {
+      // Wait for the inserts into the old buckets of the version before.
+      while (!moving_) {
+        std::this_thread::yield();
+      }
+      moved_last = MoveBuckets(state, MOVED_BUCKETS_PER_WRITE);
+      if (Probe(state.old_buckets_, hash_value, false, false, nullptr,
+                [this, &key, &value](auto *block_page, slot_offset_t slot) {
+                  return block_page->IsReadable(slot) && comparator_(key, block_page->KeyAt(slot)) == 0 &&
+                         value == block_page->ValueAt(slot);
+                })) {
+        Leave(version);
+        if (moved_last) {
+          Grow(version, false);
+        }
+        return false;
+      }
+    }
+    // The pair is counted before it is inserted. While pairs are being moved, the new buckets must keep room for the
+    // ones still in the old buckets, so the insert waits for the resize if it would overload them.
+    num_pairs_++;
+    if (moving && IsOverloaded(state)) {
+      num_pairs_--;
+      Leave(version);
+      Grow(version, true);
+      continue;
+    }
+    bool inserted = false;
+    const bool full = !InsertPair(state.buckets_, hash_value, key, value, &inserted);
+    num_pairs_ -= inserted ? 0 : 1;
+    const bool overloaded = inserted && IsOverloaded(state);
+    Leave(version);
+    if (full) {
+      // Only with a maximum load factor of 1, or while a resize is starting; grow if need be and try again.
+      Grow(version, true);
+      continue;
+    }
+    if (overloaded || moved_last) {
+      Grow(version, false);
+    }
+    return inserted;
   }
-  table_latch_.RUnlock();
-  return insert_helper_res;
 }
 
 /*****************************************************************************
@@ -172,46 +339,38 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
   const uint64_t hash_value = hash_fn_.GetHash(key);
-  table_latch_.RLock();
-  const size_t hash_position = hash_value % size_cache;
-  const auto page_postion = GetPagePosition(hash_position);
-  const size_t page_index_start = page_postion.first;
-  const slot_offset_t slot_offset_start = page_postion.second;
-  size_t page_index = page_postion.first;
-  slot_offset_t slot_offset = page_postion.second;
-  auto bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-  bpm_page->WLatch();
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-  while (block_page->IsOccupied(slot_offset)) {
-    if (block_page->IsReadable(slot_offset)
-        && comparator_(key, block_page->KeyAt(slot_offset)) == 0
-        && value == block_page->ValueAt(slot_offset)) {
+  auto remove = [this, &key, &value](auto *block_page, slot_offset_t slot_offset) {
+    if (block_page->IsReadable(slot_offset) && comparator_(key, block_page->KeyAt(slot_offset)) == 0 &&
+        value == block_page->ValueAt(slot_offset)) {
       block_page->Remove(slot_offset);
-      bpm_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      table_latch_.RUnlock();
       return true;
     }
-
-    if (++slot_offset == ((page_index == page_number - 1) ? BLOCK_ARRAY_SIZE_LAST_PAGE : BLOCK_ARRAY_SIZE_PRO_PAGE)) {
-      slot_offset = 0;
-      bpm_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-      if (++page_index == page_number) {
-        page_index = 0;
-      }
-      bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-      bpm_page->WLatch();
-      block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-    }
-    if (page_index_start == page_index && slot_offset_start == slot_offset) {
-      break;
+    return false;
+  };
+  const uint64_t version = Enter();
+  const TableState &state = states_[version % 2];
+  bool moved_last = false;
+  bool removed = false;
+  if (!state.old_buckets_.page_ids_.empty()) {
+    // Wait for the resize to count the tombstones of the new buckets from zero.
+    while (!moving_) {
+      std::this_thread::yield();
     }
+    moved_last = MoveBuckets(state, MOVED_BUCKETS_PER_WRITE);
+    // The old buckets first: a pair that is being moved is in the new ones once it is gone from the old ones.
+    removed = Probe(state.old_buckets_, hash_value, true, false, nullptr, remove);
+  }
+  if (!removed && Probe(state.buckets_, hash_value, true, false, nullptr, remove)) {
+    // The tombstones of the old buckets go with them.
+    num_tombstones_++;
+    removed = true;
   }
-  bpm_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
-  table_latch_.RUnlock();
-  return false;
+  num_pairs_ -= removed ? 1 : 0;
+  Leave(version);
+  if (moved_last) {
+    Grow(version, false);
+  }
+  return removed;
 }
 
 /*****************************************************************************
@@ -219,72 +378,154 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Resize(size_t initial_size) {
-  table_latch_.WLock();
-
-  // 1. In-memory cache all key-value pair
-  std::vector<std::pair<KeyType, ValueType>> pair_cache;
-//  pair_cache.reserve()
-  assert(page_number == page_ids_cache.size());
-  for (size_t page_index = 0; page_index < page_number; page_index++) {
-    auto bpm_page = buffer_pool_manager_->FetchPage(page_ids_cache[page_index]);
-    bpm_page->RLatch();
-    auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(bpm_page->GetData());
-    for (slot_offset_t slot_offset = 0;
-         slot_offset < ((page_index == page_number - 1) ? BLOCK_ARRAY_SIZE_LAST_PAGE : BLOCK_ARRAY_SIZE_PRO_PAGE);
-         slot_offset++) {
-      if (block_page->IsReadable(slot_offset)) {
-        pair_cache.emplace_back(block_page->KeyAt(slot_offset), block_page->ValueAt(slot_offset));
-        block_page->Remove(slot_offset);
-      }
+  std::scoped_lock resize_latch(resize_latch_);
+  StartResize(initial_size * 2);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Grow(uint64_t version, bool wait) {
+  std::unique_lock<std::mutex> resize_latch(resize_latch_, std::defer_lock);
+  if (wait) {
+    resize_latch.lock();
+  } else if (!resize_latch.try_lock()) {
+    return;
+  }
+  // Only resizes publish versions, and they hold resize_latch_.
+  const TableState &state = states_[version_ % 2];
+  const bool overloaded = IsOverloaded(state, wait ? 1 : 0);
+  // An insert that found no room grows the table unless a resize got there first, even if the counts are too low
+  // for that, as they can be after the table was reopened.
+  if (!overloaded && !(wait && version_ == version)) {
+    // The operation that moved the last old bucket finishes the resize.
+    if (!state.old_buckets_.page_ids_.empty() && moved_buckets_ == state.old_buckets_.size_) {
+      FinishResize();
     }
-    bpm_page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_ids_cache[page_index], false);
+    return;
   }
+  // Purge the tombstones if they are most of the load. Either way, the new buckets must hold the pairs and the
+  // inserts that go on while the pairs are moved, one for every MOVED_BUCKETS_PER_WRITE old buckets, or the inserts
+  // wait for the resize.
+  const size_t size = state.buckets_.size_;
+  const size_t headroom = size / MOVED_BUCKETS_PER_WRITE + 1;
+  const bool purge =
+      overloaded && static_cast<double>(num_pairs_) * 2 <= max_load_factor_ * static_cast<double>(size);
+  size_t num_buckets = purge ? size : size * 2;
+  while (static_cast<double>(num_pairs_ + headroom) > max_load_factor_ * static_cast<double>(num_buckets)) {
+    num_buckets *= 2;
+  }
+  StartResize(num_buckets);
+}
 
-  // 2. Resize
-  const size_t old_page_number = page_number;
-  const size_t num_buckets = initial_size * 2;
-  // this assesstion is wrong: not necessary to have more page. example num_buckets_ = 2, resize to 4
-//  assert((num_buckets - 1) / BLOCK_ARRAY_SIZE_PRO_PAGE + 1 > page_number);
-  page_number = (num_buckets - 1) / BLOCK_ARRAY_SIZE_PRO_PAGE + 1;
-  BLOCK_ARRAY_SIZE_LAST_PAGE = num_buckets - BLOCK_ARRAY_SIZE_PRO_PAGE * (page_number - 1);
-  size_cache = num_buckets;
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StartResize(size_t num_buckets) {
+  FinishResize();
+  // The new block pages are allocated before anybody has to wait for them.
+  BucketArray buckets = AllocateBuckets(num_buckets);
+  const TableState &state = states_[version_ % 2];
 
-  // allocate block pages for the bucket number
-  page_id_t page_id;
-  for (size_t i = 0; i < page_number - old_page_number; i++) {
-    buffer_pool_manager_->NewPage(&page_id);
-    page_ids_cache.emplace_back(page_id);
-    buffer_pool_manager_->UnpinPage(page_id, false);
+  auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
+  bpm_head_page->WLatch();
+  auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
+  for (page_id_t page_id : buckets.page_ids_) {
+    ht_header_page->AddBlockPageId(page_id);
   }
+  ht_header_page->SetOldSize(state.buckets_.size_);
+  ht_header_page->SetMovedBuckets(0);
+  ht_header_page->SetSize(buckets.size_);
+  ht_header_page->SetNumPairs(num_pairs_);
+  ht_header_page->SetNumTombstones(0);
+  bpm_head_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 
+  moving_ = false;
+  claimed_buckets_ = 0;
+  moved_buckets_ = 0;
+  resizing_ = true;
+  Publish(TableState{std::move(buckets), state.buckets_});
+  // Nothing inserts into the old buckets any more, nor removes from the new ones.
+  num_tombstones_ = 0;
+  moving_ = true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::MoveBuckets(const TableState &state, size_t count) {
+  const BucketArray &old_buckets = state.old_buckets_;
+  const size_t begin = claimed_buckets_.fetch_add(count);
+  if (begin >= old_buckets.size_) {
+    return false;
+  }
+
+  const size_t end = std::min(begin + count, old_buckets.size_);
+  for (size_t bucket = begin; bucket < end;) {
+    const auto page_postion = GetPagePosition(bucket);
+    const page_id_t page_id = old_buckets.page_ids_[page_postion.first];
+    auto bpm_page = buffer_pool_manager_->FetchPage(page_id);
+    bpm_page->WLatch();
+    auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator> *>(bpm_page->GetData());
+    const slot_offset_t slot_end =
+        std::min(NumSlots(old_buckets, page_postion.first), page_postion.second + (end - bucket));
+    for (slot_offset_t slot_offset = page_postion.second; slot_offset < slot_end; slot_offset++) {
+      if (!block_page->IsReadable(slot_offset)) {
+        continue;
+      }
+      const KeyType key = block_page->KeyAt(slot_offset);
+      const ValueType value = block_page->ValueAt(slot_offset);
+      bool inserted = false;
+      [[maybe_unused]] const bool fits = InsertPair(state.buckets_, hash_fn_.GetHash(key), key, value, &inserted);
+      BUSTUB_ASSERT(fits && inserted, "The new buckets must hold all the pairs.");
+      // The bucket stays occupied, so the probe sequences through it stay intact until the old array is dropped.
+      block_page->Remove(slot_offset);
+    }
+    bpm_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    bucket += slot_end - page_postion.second;
+  }
 
-  // 3. Update head page
-  // 3.1. add block page id to the header page
   auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
   bpm_head_page->WLatch();
+  const size_t moved_buckets = moved_buckets_ += end - begin;
   auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
-  for (size_t i = old_page_number; i < page_number; i++) {
-    ht_header_page->AddBlockPageId(page_ids_cache[i]);
+  ht_header_page->SetMovedBuckets(std::max(ht_header_page->GetMovedBuckets(), moved_buckets));
+  ht_header_page->SetNumPairs(num_pairs_);
+  ht_header_page->SetNumTombstones(num_tombstones_);
+  bpm_head_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+  return moved_buckets == old_buckets.size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::FinishResize() {
+  const TableState &state = states_[version_ % 2];
+  if (state.old_buckets_.page_ids_.empty()) {
+    return;
   }
-  // 3.2. update size
-  ht_header_page->SetSize(num_buckets);
+  const uint64_t version = Enter();
+  while (claimed_buckets_ < state.old_buckets_.size_) {
+    MoveBuckets(state, slots_per_page_);
+  }
+  Leave(version);
+  // Wait for the buckets other operations are still moving.
+  while (moved_buckets_ < state.old_buckets_.size_) {
+    std::this_thread::yield();
+  }
+
+  auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
+  bpm_head_page->WLatch();
+  auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
+  ht_header_page->RemoveBlockPageIds(state.old_buckets_.page_ids_.size());
+  ht_header_page->SetOldSize(0);
+  ht_header_page->SetMovedBuckets(0);
+  ht_header_page->SetNumPairs(num_pairs_);
+  ht_header_page->SetNumTombstones(num_tombstones_);
   bpm_head_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(header_page_id_, true);
 
-  // 4. Rehash
-  for (const auto& pair : pair_cache) {
-    [[maybe_unused]] bool insert_helper_res = false;
-    try {
-      insert_helper_res = Insert_Helper(nullptr, pair.first, pair.second);
-    } catch (hash_table_full_error) {
-      table_latch_.WUnlock();
-      assert(false);  // SHOULD NOT HAPPEN!!
-//      throw hash_table_full_error{};
-    }
-    assert(insert_helper_res);
+  const std::vector<page_id_t> old_page_ids = state.old_buckets_.page_ids_;
+  Publish(TableState{state.buckets_, BucketArray()});
+  resizing_ = false;
+  for (page_id_t page_id : old_page_ids) {
+    buffer_pool_manager_->DeletePage(page_id);
   }
-  table_latch_.WUnlock();
 }
 
 /*****************************************************************************
@@ -292,18 +533,26 @@ void HASH_TABLE_TYPE::Resize(size_t initial_size) {
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  table_latch_.RLock();
   auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
   bpm_head_page->RLatch();
   auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
   const auto size = ht_header_page->GetSize();
   bpm_head_page->RUnlatch();
   buffer_pool_manager_->UnpinPage(header_page_id_, false);
-  assert(size == size_cache);
-  table_latch_.RUnlock();
   return size;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::FlushCounts() {
+  auto bpm_head_page = buffer_pool_manager_->FetchPage(header_page_id_);
+  bpm_head_page->WLatch();
+  auto ht_header_page = reinterpret_cast<HashTableHeaderPage *>(bpm_head_page->GetData());
+  ht_header_page->SetNumPairs(num_pairs_);
+  ht_header_page->SetNumTombstones(num_tombstones_);
+  bpm_head_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+}
+
 template class LinearProbeHashTable<int, int, IntComparator>;
 template class LinearProbeHashTable<GenericKey<4>, RID, GenericComparator<4>>;
 template class LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
@@ -12,11 +12,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <thread>        // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_ring.h"
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -25,6 +35,13 @@ namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The frames can be split into several partitions. Every partition has its own page table, free list, replacer and
+ * latch, and a page always lives in the partition selected by its page id, so threads working on pages of different
+ * partitions never contend with each other.
+ *
+ * The data of all frames is one mapping of pool_size * PAGE_SIZE bytes, so every frame is aligned to PAGE_SIZE and
+ * can be the target of O_DIRECT I/O (see DiskManager). It can optionally be backed by huge pages.
  */
 class BufferPoolManager {
  public:
@@ -36,8 +53,15 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param num_instances the number of partitions the frames are split into (clamped to [1, pool_size])
+   * @param replacer_type the replacement policy used by every partition
+   * @param replacer_k the lookback of the LRU-K replacer, ignored by the other policies
+   * @param use_huge_pages true to back the frames with huge pages: explicitly reserved ones if the system has enough,
+   * transparent ones otherwise
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    size_t num_instances = 1, ReplacerType replacer_type = ReplacerType::CLOCK,
+                    size_t replacer_k = LRUK_REPLACER_K, bool use_huge_pages = false);
 
   /**
    * Destroys an existing BufferPoolManager.
@@ -91,13 +115,98 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetches a page on behalf of a sequential scan. Resident pages are pinned like FetchPage does, but on a miss the
+   * page is read into a frame of the ring: once the ring is full, its oldest frame is recycled as long as nobody else
+   * has pinned it or loaded another page into it since, so the scan does not push other pages out of the pool.
+   * @param page_id id of page to be fetched
+   * @param ring the ring of the scan, nullptr to fetch like FetchPage
+   * @return the requested page, nullptr if no frame was available
+   */
+  Page *FetchPageWithRing(page_id_t page_id, BufferRing *ring) { return FetchPageImpl(page_id, ring); }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /** @return the number of partitions of the buffer pool */
+  size_t GetNumInstances() { return partitions_.size(); }
+
+  /**
+   * Starts the background writer. Every bg_writer_interval, and whenever a miss had to write a dirty victim itself,
+   * it flushes dirty unpinned pages until num_clean_frames frames (split over the partitions) are free or clean and
+   * unpinned, so that misses can evict without writing. If logging is enabled, pages whose LSN is not persistent
+   * yet are left alone.
+   * @param num_clean_frames the number of clean, evictable frames to keep available
+   */
+  void StartBackgroundWriter(size_t num_clean_frames);
+
+  /** Stops and joins the background writer, if it is running. */
+  void StopBackgroundWriter();
+
+  /**
+   * Asks for pages to be read into the buffer pool in the background, so that a later FetchPage of them is a hit.
+   * Returns immediately. Pages that are resident, have never been written to disk, or for which no frame is free
+   * or evictable are skipped; prefetched pages are left unpinned.
+   *
+   * Given the BufferRing of a scan, the pages are read into the frames of the ring, like FetchPageWithRing does. The
+   * frames are then picked right away by the calling thread, which must be the thread of the scan; only the I/O
+   * happens in the background.
+   * @param page_ids ids of the pages that are going to be fetched soon
+   * @param ring the ring of the scan that is going to fetch them, nullptr to use any frame
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids, BufferRing *ring = nullptr);
+
+  /** @return the number of pages that were read into the buffer pool by PrefetchPages */
+  size_t GetNumPrefetched() { return num_prefetched_; }
+
+  /** @return the number of dirty victims that a fetch or new page had to write on its own */
+  size_t GetNumForegroundWrites() { return num_foreground_writes_; }
+
+  /** @return the number of dirty pages written off the critical path, by the background writer */
+  size_t GetNumBackgroundWrites() { return num_background_writes_; }
+
  private:
+  /**
+   * A partition owns a contiguous slice of the frames. Frame ids handed to its replacer and stored in its page table
+   * are local to the partition, i.e. frame i of the partition is pages_[i].
+   *
+   * Hits only take latch_ in shared mode and pin with an atomic increment, they never touch the replacer. The thread
+   * that drops a pin count to zero hands the frame to the replacer, so the replacer may still contain frames that
+   * were pinned again since; FindFreeFrame skips those. Anything that changes the page table or picks a victim holds
+   * latch_ exclusively, which keeps pin counts from leaving zero while a victim is chosen.
+   */
+  struct Partition {
+    Partition(Page *pages, size_t pool_size, ReplacerType replacer_type, size_t replacer_k);
+    ~Partition();
+
+    /**
+     * Takes a frame from the free list, or else a victim from the replacer. Requires latch_ in exclusive mode.
+     * @param[out] frame_id the frame that was found
+     * @param clean true to skip dirty victims, which stay in the replacer
+     * @return false if every frame of this partition is pinned, or dirty if clean is set
+     */
+    bool FindFreeFrame(frame_id_t *frame_id, bool clean = false);
+
+    /** Number of frames in this partition. */
+    size_t pool_size_;
+    /** The first frame of this partition, points into BufferPoolManager::pages_. */
+    Page *pages_;
+    /** Page table for keeping track of the pages of this partition. */
+    std::unordered_map<page_id_t, frame_id_t> page_table_;
+    /** Replacer to find unpinned frames of this partition for replacement. */
+    Replacer *replacer_;
+    /** List of free frames of this partition. */
+    std::list<frame_id_t> free_list_;
+    /** Protects page_table_ and free_list_; shared for pinning resident pages, exclusive for everything else. */
+    std::shared_mutex latch_;
+  };
+
+  /** @return the partition that is responsible for page_id */
+  Partition *GetPartition(page_id_t page_id) { return partitions_[page_id % partitions_.size()].get(); }
+
   /**
    * Grading function. Do not modify!
    * Invokes the callback function if it is not null.
@@ -114,9 +223,10 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param ring the ring to read the page into on a miss, nullptr to use the free list and the replacer
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  Page *FetchPageImpl(page_id_t page_id, BufferRing *ring = nullptr);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -148,28 +258,103 @@ class BufferPoolManager {
   bool DeletePageImpl(page_id_t page_id);
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk and syncs the database file.
    */
   void FlushAllPagesImpl();
 
-  // (For Fetch or New) Update relevant metadata and page_table.
-  Page *ReplaceAndUpdate(page_id_t new_page_id, bool new_page, std::unique_lock<std::shared_mutex> *u_lock);
+  /**
+   * Finds the frame a ring reads page_id into: the next frame of the ring if it can be recycled, otherwise a frame
+   * from FindFreeFrame, which then replaces that slot of the ring. Requires part->latch_ in exclusive mode.
+   * @param part the partition of page_id
+   * @param page_id the page that is going to be read
+   * @param ring the ring of the scan
+   * @param[out] frame_id the frame that was found
+   * @param clean true to take only a frame whose page is not dirty
+   * @return false if every frame of the partition is pinned, or dirty if clean is set
+   */
+  bool FindRingFrame(Partition *part, page_id_t page_id, BufferRing *ring, frame_id_t *frame_id, bool clean = false);
+
+  /**
+   * One round of the background writer: flushes dirty unpinned pages of every partition that has fewer than
+   * clean_target clean, evictable frames.
+   * @param clean_target the number of clean, evictable frames to reach per partition
+   */
+  void BackgroundWriteRound(size_t clean_target);
+
+  /**
+   * Installs the pages of a prefetch that are not resident yet into frames, see InstallPage. Only frames whose page
+   * is clean are taken, a prefetch never has to write a victim.
+   * @param page_ids the pages to prefetch
+   * @param ring the ring to take the frames from, nullptr to use any frame
+   * @return the installed pages, pinned and write latched
+   */
+  std::vector<Page *> InstallPrefetch(const std::vector<page_id_t> &page_ids, BufferRing *ring);
+
+  /**
+   * Reads installed pages, with all of the reads in flight at once, and leaves them unlatched and unpinned. Runs on
+   * the prefetch thread.
+   */
+  void LoadPrefetch(const std::vector<Page *> &loads);
+
+  /** Stops and joins the prefetch thread, if it is running. */
+  void StopPrefetcher();
+
+  // (For Fetch or New) Point the frame at new_page_id in page_table and pin it, releases u_lock. The page is returned
+  // write latched and without content; dirty_page_id is the page that still has to be written from it, if any.
+  Page *InstallPage(Partition *part, frame_id_t index, page_id_t new_page_id, bool new_page,
+                    std::unique_lock<std::shared_mutex> *u_lock, page_id_t *dirty_page_id);
+
+  // (For New) Creates new_page_id, a page id the disk manager has just handed out again, in the partition. Returns
+  // nullptr if every frame is pinned. Releases u_lock.
+  Page *CreatePage(Partition *part, page_id_t new_page_id, std::unique_lock<std::shared_mutex> *u_lock);
+
+  // (For Fetch or New) Load new_page_id into the frame, update relevant metadata and page_table. Releases u_lock.
+  Page *ReplaceAndUpdate(Partition *part, frame_id_t index, page_id_t new_page_id, bool new_page,
+                         std::unique_lock<std::shared_mutex> *u_lock);
 
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
-  /** Array of buffer pool pages. */
+  /** Array of buffer pool pages, shared by all the partitions. */
   Page *pages_;
+  /** The data of the frames, pages_[i] uses the PAGE_SIZE bytes at frames_ + i * PAGE_SIZE. */
+  char *frames_;
+  /** Size of the mapping at frames_. */
+  size_t frames_size_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
-  /** List of free pages. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::shared_mutex latch_;
+  /** The partitions of the buffer pool, a page lives in partitions_[page_id % partitions_.size()]. */
+  std::vector<std::unique_ptr<Partition>> partitions_;
+
+  /** Number of dirty victims written on the critical path of a fetch or new page. */
+  std::atomic<size_t> num_foreground_writes_{0};
+  /** Number of dirty pages written by the background writer. */
+  std::atomic<size_t> num_background_writes_{0};
+  /** The background writer thread, not joinable if the background writer is not running. */
+  std::thread bg_writer_thread_;
+  /** True while the background writer should keep running. Protected by bg_writer_latch_. */
+  bool bg_writer_running_{false};
+  /** Protects bg_writer_running_, used with bg_writer_cv_. */
+  std::mutex bg_writer_latch_;
+  /** Wakes up the background writer early, on shutdown or after a foreground write. */
+  std::condition_variable bg_writer_cv_;
+  /** Per partition position at which the background writer continues looking for dirty pages. */
+  std::vector<size_t> bg_writer_cursors_;
+
+  /** Number of pages read by the prefetch thread. */
+  std::atomic<size_t> num_prefetched_{0};
+  /** The prefetch thread, started by the first PrefetchPages. */
+  std::thread prefetch_thread_;
+  /** Pages waiting to be prefetched. Protected by prefetch_latch_. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** Pages installed into the frames of a ring, waiting for their I/O. Protected by prefetch_latch_. */
+  std::deque<std::vector<Page *>> prefetch_loads_;
+  /** True while the prefetch thread should keep running. Protected by prefetch_latch_. */
+  bool prefetch_running_{false};
+  /** Protects prefetch_queue_, prefetch_loads_ and prefetch_running_, used with prefetch_cv_. */
+  std::mutex prefetch_latch_;
+  /** Wakes up the prefetch thread when pages are queued or on shutdown. */
+  std::condition_variable prefetch_cv_;
 };
 }  // namespace bustub
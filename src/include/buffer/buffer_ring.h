@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.h
+//
+// Identification: src/include/buffer/buffer_ring.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferRing is a small private set of frames that a sequential scan cycles through.
+ *
+ * Pages the scan misses on are read into the frames of the ring instead of frames chosen by the replacer, so that a
+ * scan over a table much larger than the buffer pool only ever takes ring_size frames away from everyone else. Pages
+ * that are already resident are pinned as usual and never enter the ring.
+ *
+ * A ring belongs to a single scan and is not thread-safe. It is only filled and consulted by
+ * BufferPoolManager::FetchPageWithRing.
+ */
+class BufferRing {
+  friend class BufferPoolManager;
+
+ public:
+  /**
+   * Creates a new, empty ring.
+   * @param ring_size the maximum number of frames the ring holds on to
+   */
+  explicit BufferRing(size_t ring_size = SCAN_RING_SIZE) : ring_size_(ring_size) {}
+
+  /** @return the maximum number of frames the ring holds on to */
+  size_t GetRingSize() const { return ring_size_; }
+
+  /** @return how many misses were served by recycling a frame of the ring */
+  size_t GetNumRecycled() const { return num_recycled_; }
+
+ private:
+  /** A frame of the ring and the page the scan read into it. */
+  struct Slot {
+    frame_id_t frame_id_;
+    page_id_t page_id_;
+  };
+
+  /** Maximum number of frames of the ring. */
+  size_t ring_size_;
+  /** Frames of the ring, per buffer pool partition. Sized on first use. */
+  std::vector<std::vector<Slot>> slots_;
+  /** Next slot to recycle, per buffer pool partition. */
+  std::vector<size_t> cursors_;
+  /** Number of misses served by recycling a frame. */
+  size_t num_recycled_{0};
+};
+
+}  // namespace bustub
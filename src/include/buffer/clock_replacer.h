@@ -12,10 +12,9 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>         // NOLINT
-#include <shared_mutex>  // NOLINT
-#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
 
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -24,6 +23,9 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Pin and Unpin only flip the per-frame state bits atomically, so they never block. Victim serializes on a latch
+ * because it moves the clock hand.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -47,19 +49,19 @@ class ClockReplacer : public Replacer {
   size_t Size() override;
 
  private:
-  // actual size of clock
-  size_t size = 0;
+  // number of frames that exist in the clock
+  std::atomic<size_t> size = 0;
 
-  // <exist, pin>
-  std::vector<std::pair<bool, bool>> clock;
+  // per frame state, a combination of the EXISTS and REF bits
+  size_t num_frames;
+  std::unique_ptr<std::atomic<uint8_t>[]> clock;
   size_t hand = 0;  // clock hand index
 
-  static constexpr bool NOT_EXISTS = false;
-  static constexpr bool EXISTS = true;
-  static constexpr bool NO_REF = false;
-  static constexpr bool REF = true;
+  static constexpr uint8_t EXISTS = 0b01;
+  static constexpr uint8_t REF = 0b10;
 
-  mutable std::shared_mutex latch;
+  // protects hand
+  std::mutex latch;
 };
 
 }  // namespace bustub
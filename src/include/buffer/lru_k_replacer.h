@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every Unpin counts as an access to the frame. The victim is the evictable frame whose K-th most recent access is
+ * the oldest (largest backward K-distance). Frames with fewer than K accesses have an infinite backward K-distance and
+ * are evicted first, least recently accessed first. Pages touched once by a sequential scan therefore leave before
+ * pages that are looked up repeatedly.
+ *
+ * A victim keeps its history until the frame is Reset for a different page: the buffer pool manager may drop a
+ * victim that was pinned again in the meantime, and the page it keeps must not lose its accesses.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses the backward K-distance looks back
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Reset(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** @return the key the frame is ordered by in its evictable set */
+  size_t OrderKey(frame_id_t frame_id) const;
+
+  /** Adds the frame to the evictable set matching its history. */
+  void AddEvictable(frame_id_t frame_id);
+
+  /** Removes the frame from the evictable set matching its history. */
+  void RemoveEvictable(frame_id_t frame_id);
+
+  size_t k_;
+  size_t current_timestamp_{0};
+
+  // timestamps of the (at most k_) most recent accesses of each frame, oldest first
+  std::vector<std::deque<size_t>> history_;
+  std::vector<bool> evictable_;
+
+  // evictable frames with fewer than k_ accesses, ordered by their most recent access
+  std::set<std::pair<size_t, frame_id_t>> young_;
+  // evictable frames with k_ accesses, ordered by their k-th most recent access
+  std::set<std::pair<size_t, frame_id_t>> old_;
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
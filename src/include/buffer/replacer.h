@@ -16,6 +16,9 @@
 
 namespace bustub {
 
+/** The replacement policies the buffer pool manager can be configured with. */
+enum class ReplacerType { CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +46,12 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets what the replacer knows about the accesses of a frame, which now holds a different page.
+   * @param frame_id the id of the frame
+   */
+  virtual void Reset(frame_id_t frame_id [[maybe_unused]]) {}
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -61,6 +61,8 @@ class SimpleCatalog {
         table_oid,
         std::make_unique<TableMetadata>(
             schema, table_name, std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn), table_oid));
+    // Lets scans skip pages by the values of the fixed-width columns.
+    iter.first->second->table_->CreateZoneMap(schema, txn);
     return iter.first->second.get();
   }
 
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
@@ -34,11 +36,36 @@ namespace bustub {
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table dynamically grows once full.
+ * table dynamically grows once its pairs and tombstones take up more than the
+ * maximum load factor of its buckets. If most of them are tombstones, it is
+ * rehashed into as many buckets instead, which purges them.
+ *
+ * Operations only latch the block pages they probe, one at a time. The arrays of buckets they probe are a version
+ * of the table: an operation registers with the current version when it starts, and a resize that publishes the
+ * next version waits for the operations on the previous one to finish before it goes on. There are two versions at
+ * most, the current one and the one before it.
+ *
+ * A resize moves the pairs to a new array of buckets incrementally: every insert and remove first moves the pairs
+ * of the next MOVED_BUCKETS_PER_WRITE buckets of the old array. Until all of them have been moved, lookups and
+ * removes probe the old array and then the new one, and inserts go to the new one. An insert that would take the new
+ * array over the maximum load factor waits for the resize, so the new array always has room for the pairs still to
+ * be moved. A pair is moved by inserting it into the new array while its old block page is latched, and only then
+ * removing it from the old one, so a lookup may find it twice but never misses it. Once all the pairs have been
+ * moved, the next version drops the old array, whose block pages are deleted when the operations on the version
+ * before have finished.
+ *
+ * The block pages can be laid out with fingerprints (see HashTableBlockPage): every bucket then has the top 7 bits
+ * of the hash of its key, and a probe only compares the keys of the readable buckets whose fingerprint matches. A
+ * block page holds fewer buckets that way, which pays off when comparing keys is expensive.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
  public:
+  /** The number of old buckets an insert or remove moves while a resize is under way. */
+  static constexpr size_t MOVED_BUCKETS_PER_WRITE = 64;
+  /** The default share of the buckets that may hold pairs or tombstones before the table grows. */
+  static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.75;
+
   /**
    * Creates a new LinearProbeHashTable
    *
@@ -46,13 +73,34 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    * @param comparator comparator for keys
    * @param num_buckets initial number of buckets contained by this hash table
    * @param hash_fn the hash function
+   * @param max_load_factor the share of the buckets that may hold pairs or tombstones before the table grows, in (0, 1]
+   * @param fingerprints true to lay out the block pages with fingerprints
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
+                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn,
+                                double max_load_factor = DEFAULT_MAX_LOAD_FACTOR, bool fingerprints = false);
+
+  /**
+   * Opens a LinearProbeHashTable from its header page. A resize that was under way is finished first.
+   *
+   * The counts of pairs and tombstones are read back from the header page, which has them as of the last resize step
+   * or FlushCounts(). Counts that are too high only make the table grow early; with counts that are too low, it
+   * grows once an insert finds no room.
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param header_page_id the header page of the table
+   * @param hash_fn the hash function
+   * @param max_load_factor the share of the buckets that may hold pairs or tombstones before the table grows, in (0, 1]
+   * @param fingerprints true if the block pages are laid out with fingerprints, as when the table was created
+   */
+  LinearProbeHashTable(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                       page_id_t header_page_id, HashFunction<KeyType> hash_fn,
+                       double max_load_factor = DEFAULT_MAX_LOAD_FACTOR, bool fingerprints = false);
 
   /**
    * Inserts a key-value pair into the hash table.
-   * When hash table is full, throws the exception `hash_table_full_error`.
+   * The hash table grows when the insert takes it over the maximum load factor.
    * @param transaction the current transaction
    * @param key the key to create
    * @param value the value to be associated with the key
@@ -79,8 +127,9 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
-   * @param initial_size the initial size of the hash table
+   * Resizes the table to twice the initial size provided. A resize that is still under way is finished first. The
+   * new size takes effect at once, the pairs are moved by the inserts and removes that follow.
+   * @param initial_size the initial size of the hash table, at least the number of pairs in it
    */
   void Resize(size_t initial_size);
 
@@ -90,39 +139,171 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+  /**
+   * Writes the counts of pairs and tombstones to the header page, which otherwise has them as of the last resize
+   * step. Call it before flushing the pages of the table, so that it opens again with the current counts.
+   */
+  void FlushCounts();
+
+  /** @return the page id of the header page, to open the table again */
+  page_id_t GetHeaderPageId() const { return header_page_id_; }
+
+  /** @return true if a resize is still moving pairs */
+  bool IsResizing() const { return resizing_; }
+
+  /** @return the number of key-value pairs in the hash table */
+  size_t GetNumPairs() const { return num_pairs_; }
+
+  /** @return the number of buckets whose pair was removed, and that no insert has reused yet */
+  size_t GetNumTombstones() const { return num_tombstones_; }
+
  private:
-  static constexpr slot_offset_t BLOCK_ARRAY_SIZE_PRO_PAGE{BLOCK_ARRAY_SIZE};
+  /** The number of stripes of the counts of running operations. */
+  static constexpr size_t NUM_EPOCH_SLOTS = 16;
+
+  /** An array of buckets, spread over block pages. */
+  struct BucketArray {
+    size_t size_{0};
+    std::vector<page_id_t> page_ids_;
+  };
+
+  /** The arrays of buckets of a version of the table, never changed once published. */
+  struct TableState {
+    /** The buckets of the table, the ones pairs are moved to while a resize is under way. */
+    BucketArray buckets_;
+    /** The buckets a resize under way moves the pairs from, empty if there is none. */
+    BucketArray old_buckets_;
+  };
+
+  /** A stripe of the numbers of operations that run on the versions, by version % 2, on a cache line of its own. */
+  struct alignas(64) EpochSlot {
+    std::atomic<uint64_t> active_[2]{};
+  };
 
   page_id_t header_page_id_;
-  size_t page_number;
-  slot_offset_t BLOCK_ARRAY_SIZE_LAST_PAGE;
-  size_t size_cache;
-  std::vector<page_id_t> page_ids_cache;
+  /** The current version. */
+  std::atomic<uint64_t> version_{0};
+  /** The state of the current version and of the one before it, by version % 2. */
+  TableState states_[2];
+  EpochSlot epoch_slots_[NUM_EPOCH_SLOTS];
+  std::atomic<bool> resizing_{false};
+  /** False until the operations of the version before a resize have finished, they insert into the old buckets. */
+  std::atomic<bool> moving_{false};
+  /** The number of old buckets that have been claimed to be moved, and that have been moved. */
+  std::atomic<size_t> claimed_buckets_{0};
+  std::atomic<size_t> moved_buckets_{0};
+  double max_load_factor_;
+  /** True if the block pages are laid out with fingerprints. */
+  const bool fingerprints_;
+  /** The number of buckets on a block page, fewer with fingerprints. */
+  const slot_offset_t slots_per_page_;
+  /**
+   * The pairs and tombstones of the table. Writers only count them in memory, so they never latch the header page;
+   * it has them as of the last resize step or FlushCounts().
+   */
+  std::atomic<size_t> num_pairs_{0};
+  std::atomic<size_t> num_tombstones_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
-  /** Readers includes inserts and removes, writer is only resize */
-  mutable ReaderWriterLatch table_latch_;
+  /** Serializes resizes, and publishing versions */
+  std::mutex resize_latch_;
   /** Hash function */
   HashFunction<KeyType> hash_fn_;
 
-  bool Insert_Helper(Transaction *transaction, const KeyType &key, const ValueType &value);
+  /**
+   * Registers an operation with the current version. Its state stays as it is until the operation leaves.
+   * @return the version
+   */
+  uint64_t Enter();
 
+  /** Unregisters an operation from the version it entered. */
+  void Leave(uint64_t version);
+
+  /**
+   * Makes a state the next version, and waits for the operations on the current one to finish. resize_latch_ must
+   * be held, and the calling thread must not be in an operation.
+   */
+  void Publish(TableState state);
+
+  /** @return an array of num_buckets empty buckets, on new block pages */
+  BucketArray AllocateBuckets(size_t num_buckets);
+
+  /**
+   * Walks the buckets of a probe sequence, from the bucket of the hash up to the first one that was never occupied, or
+   * once around the array. Only the readable buckets and the one that ends the walk are visited, the bitmaps of a block
+   * page are searched 64 buckets at a time for them. Every block page is latched while its buckets are visited.
+   * @param buckets the array of buckets
+   * @param hash_value the hash of the key
+   * @param exclusive true to latch the block pages in write mode, the one the walk stops on is marked dirty
+   * @param until_free true to end the walk at the first bucket that is not readable, a tombstone too
+   * @param[out] tombstone if not null, set when the walk passed a tombstone before the bucket that ends it
+   * @param visit called with the block page and slot of every bucket, the walk stops when it returns true
+   * @return true if visit stopped the walk
+   */
+  template <typename Visitor>
+  bool Probe(const BucketArray &buckets, uint64_t hash_value, bool exclusive, bool until_free, bool *tombstone,
+             Visitor &&visit);
+
+  /**
+   * Inserts a pair into an array of buckets, unless it is there already.
+   * @param[out] inserted true if the pair was inserted
+   * @return false if the array is full
+   */
+  bool InsertPair(const BucketArray &buckets, uint64_t hash_value, const KeyType &key, const ValueType &value,
+                  bool *inserted);
+
+  /**
+   * Moves the pairs of the next old buckets of a resize under way to the new array.
+   * @param state the state of the version the calling operation runs on, with old buckets
+   * @return true if this call moved the last of them
+   */
+  bool MoveBuckets(const TableState &state, size_t count);
+
+  /**
+   * Finishes a resize under way: moves the buckets no operation has moved yet, and publishes a version without the
+   * old buckets. resize_latch_ must be held.
+   */
+  void FinishResize();
+
+  /**
+   * Starts a resize, after finishing the one under way. resize_latch_ must be held.
+   * @param num_buckets the size of the new array of buckets
+   */
+  void StartResize(size_t num_buckets);
+
+  /**
+   * Doubles the buckets, or rehashes them into as many if most of the load are tombstones. The new buckets leave
+   * room within the maximum load factor for the inserts while the pairs are moved, one for every
+   * MOVED_BUCKETS_PER_WRITE old buckets; they are doubled again as long as the pairs take up that room. Does nothing
+   * but finish a resize whose pairs have all been moved if the table is not overloaded (any more).
+   * @param version the version the calling operation ran on
+   * @param wait true for an insert that found no room: waits for the resize under way, and counts its pair as part
+   * of the load; false to leave it to the resize another thread is starting
+   */
+  void Grow(uint64_t version, bool wait);
+
+  /** @return true if the pairs and tombstones, and extra more pairs, take up more than the maximum load factor */
+  bool IsOverloaded(const TableState &state, size_t extra = 0) const {
+    return static_cast<double>(num_pairs_ + num_tombstones_ + extra) >
+           max_load_factor_ * static_cast<double>(state.buckets_.size_);
+  }
+
+  /** @return the fingerprint of a hash, its top 7 bits; the lower ones pick the bucket */
+  static uint8_t Fingerprint(uint64_t hash_value) { return static_cast<uint8_t>(hash_value >> 57); }
+
+  /** @return the number of buckets on a block page of an array */
+  slot_offset_t NumSlots(const BucketArray &buckets, size_t page_index) const {
+    return page_index + 1 == buckets.page_ids_.size()
+               ? static_cast<slot_offset_t>(buckets.size_ - slots_per_page_ * page_index)
+               : slots_per_page_;
+  }
 
   std::pair<size_t, slot_offset_t> GetPagePosition(size_t hash_position) const {
-    const size_t page_index = hash_position / BLOCK_ARRAY_SIZE_PRO_PAGE;
+    const size_t page_index = hash_position / slots_per_page_;
     const slot_offset_t slot_offset
-        = hash_position % BLOCK_ARRAY_SIZE_PRO_PAGE;  // hash_position % buckets_pro_page
+        = hash_position % slots_per_page_;  // hash_position % buckets_pro_page
     return {page_index, slot_offset};
   }
 };
 
-class hash_table_full_error
-    : public std::exception {
- public:
-  const char* what() const noexcept override {
-    return "Infinite Loop: hash table is full with no empty space for insertion";
-  }
-};
-
-
 }  // namespace bustub
\ No newline at end of file
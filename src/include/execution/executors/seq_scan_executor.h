@@ -12,17 +12,25 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_ring.h"
+#include "catalog/simple_catalog.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
 /**
  * SeqScanExecutor executes a sequential scan over a table.
+ * If the predicate compares a column with a constant, the scan skips the pages whose zone map rules out a match.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -31,16 +39,136 @@ class SeqScanExecutor : public AbstractExecutor {
    * @param exec_ctx the executor context
    * @param plan the sequential scan plan to be executed
    */
-  SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
+  SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx), plan_(plan) {}
 
-  void Init() override {}
+  void Init() override {
+    table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+    ring_ = plan_->UseBufferRing() ? std::make_unique<BufferRing>() : nullptr;
+    iter_ = nullptr;
+    advance_ = false;
+    zone_map_predicate_ = MakeZoneMapPredicate();
+  }
 
-  bool Next(Tuple *tuple) override { return false; }
+  bool Next(Tuple *tuple) override {
+    if (iter_ == nullptr) {
+      // The tuples are evaluated in place, the output tuple is the only copy made per row.
+      iter_ = std::make_unique<TableIterator>(
+          table_info_->table_->Begin(exec_ctx_->GetTransaction(), ring_.get(), 0, true, zone_map_predicate_.get()));
+    } else if (advance_) {
+      ++(*iter_);
+    }
+    advance_ = false;
+    const auto *predicate = plan_->GetPredicate();
+    const auto end = table_info_->table_->End();
+    while (*iter_ != end) {
+      const Tuple &current = **iter_;
+      if (predicate == nullptr || predicate->Evaluate(&current, &table_info_->schema_).GetAs<bool>()) {
+        *tuple = MakeOutputTuple(current);
+        // Don't keep the page latched while the parent works with the tuple, move on in the next call.
+        iter_->Release();
+        advance_ = true;
+        return true;
+      }
+      ++(*iter_);
+    }
+    return false;
+  }
 
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
  private:
+  /**
+   * Translates a predicate of the form column op constant, or constant op column, into a zone map predicate.
+   * @return the zone map predicate, nullptr if the predicate has a different form
+   */
+  std::unique_ptr<ZoneMap::Predicate> MakeZoneMapPredicate() const {
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+    if (comparison == nullptr) {
+      return nullptr;
+    }
+    ComparisonType comp_type = comparison->GetComparisonType();
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+    const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+    if (column == nullptr) {
+      // Swap the operands, and turn the comparison around with them.
+      column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+      constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+      switch (comp_type) {
+        case ComparisonType::LessThan:
+          comp_type = ComparisonType::GreaterThan;
+          break;
+        case ComparisonType::LessThanOrEqual:
+          comp_type = ComparisonType::GreaterThanOrEqual;
+          break;
+        case ComparisonType::GreaterThan:
+          comp_type = ComparisonType::LessThan;
+          break;
+        case ComparisonType::GreaterThanOrEqual:
+          comp_type = ComparisonType::LessThanOrEqual;
+          break;
+        default:
+          break;
+      }
+    }
+    if (column == nullptr || constant == nullptr) {
+      return nullptr;
+    }
+    Value value = constant->Evaluate(nullptr, nullptr);
+    if (value.IsNull()) {
+      return nullptr;
+    }
+    return std::make_unique<ZoneMap::Predicate>(ZoneMap::Predicate{
+        column->GetColIdx(), [comp_type, value](const ZoneMap::ColumnSummary &summary) {
+          // What a comparison with null yields is up to the predicate, so pages with nulls are always read.
+          if (summary.null_count_ > 0) {
+            return true;
+          }
+          if (summary.min_.IsNull()) {
+            return false;
+          }
+          switch (comp_type) {
+            case ComparisonType::Equal:
+              return summary.min_.CompareLessThanEquals(value) == CmpBool::CmpTrue &&
+                     summary.max_.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+            case ComparisonType::NotEqual:
+              return summary.min_.CompareNotEquals(value) == CmpBool::CmpTrue ||
+                     summary.max_.CompareNotEquals(value) == CmpBool::CmpTrue;
+            case ComparisonType::LessThan:
+              return summary.min_.CompareLessThan(value) == CmpBool::CmpTrue;
+            case ComparisonType::LessThanOrEqual:
+              return summary.min_.CompareLessThanEquals(value) == CmpBool::CmpTrue;
+            case ComparisonType::GreaterThan:
+              return summary.max_.CompareGreaterThan(value) == CmpBool::CmpTrue;
+            case ComparisonType::GreaterThanOrEqual:
+              return summary.max_.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+            default:
+              return true;
+          }
+        }});
+  }
+
+  /** @return the columns of the output schema, evaluated against a tuple of the table */
+  Tuple MakeOutputTuple(const Tuple &current) {
+    const auto *output_schema = GetOutputSchema();
+    std::vector<Value> values;
+    values.reserve(output_schema->GetColumnCount());
+    for (const auto &column : output_schema->GetColumns()) {
+      values.emplace_back(column.GetExpr()->Evaluate(&current, &table_info_->schema_));
+    }
+    return Tuple(values, output_schema);
+  }
+
   /** The sequential scan plan node to be executed. */
   const SeqScanPlanNode *plan_;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /** The ring the scan reads through, nullptr if the plan does not ask for one. */
+  std::unique_ptr<BufferRing> ring_;
+  /** The pages the scan skips, nullptr if it reads all of them. */
+  std::unique_ptr<ZoneMap::Predicate> zone_map_predicate_;
+  /** The position of the scan. */
+  std::unique_ptr<TableIterator> iter_;
+  /** True if the iterator is still on the tuple returned last. */
+  bool advance_{false};
 };
 }  // namespace bustub
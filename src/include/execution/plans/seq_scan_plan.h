@@ -27,9 +27,11 @@ class SeqScanPlanNode : public AbstractPlanNode {
    * @param output the output format of this scan plan node
    * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) = true or predicate = nullptr
    * @param table_oid the identifier of table to be scanned
+   * @param use_buffer_ring true if the scan should read the table through a BufferRing instead of the shared pool
    */
-  SeqScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid)
-      : AbstractPlanNode(output, {}), predicate_{predicate}, table_oid_(table_oid) {}
+  SeqScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid,
+                  bool use_buffer_ring = false)
+      : AbstractPlanNode(output, {}), predicate_{predicate}, table_oid_(table_oid), use_buffer_ring_(use_buffer_ring) {}
 
   PlanType GetType() const override { return PlanType::SeqScan; }
 
@@ -39,11 +41,16 @@ class SeqScanPlanNode : public AbstractPlanNode {
   /** @return the identifier of the table that should be scanned */
   table_oid_t GetTableOid() const { return table_oid_; }
 
+  /** @return true if the scan should recycle a small ring of frames instead of competing for the whole pool */
+  bool UseBufferRing() const { return use_buffer_ring_; }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
   /** The table whose tuples should be scanned. */
   table_oid_t table_oid_;
+  /** Whether the scan goes through a BufferRing. */
+  bool use_buffer_ring_;
 };
 
 }  // namespace bustub
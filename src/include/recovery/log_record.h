@@ -32,6 +32,8 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** The full content of a table page, written by bulk loads instead of a record per tuple. */
+  PAGEIMAGE,
 };
 
 /**
@@ -57,6 +59,10 @@ enum class LogRecordType {
  *--------------------------
  * | HEADER | prev_page_id |
  *--------------------------
+ * For page image type log record
+ *----------------------------------------------
+ * | HEADER | page_id | page_data(char[] array) |
+ *----------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -109,6 +115,15 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t);
   }
 
+  // constructor for PAGEIMAGE type, page_data has to stay valid until the record is appended to the log
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t page_id, const char *page_data)
+      : size_(HEADER_SIZE + sizeof(page_id_t) + PAGE_SIZE),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        image_page_id_(page_id),
+        page_image_(page_data) {}
+
   ~LogRecord() = default;
 
   inline RID &GetDeleteRID() { return delete_rid_; }
@@ -119,6 +134,10 @@ class LogRecord {
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline page_id_t GetImagePageId() { return image_page_id_; }
+
+  inline const char *GetPageImage() { return page_image_; }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -166,6 +185,10 @@ class LogRecord {
 
   // case4: for new page opeartion
   page_id_t prev_page_id_{INVALID_PAGE_ID};
+
+  // case5: for page image operation
+  page_id_t image_page_id_{INVALID_PAGE_ID};
+  const char *page_image_{nullptr};
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
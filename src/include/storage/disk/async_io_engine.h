@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_engine.h
+//
+// Identification: src/include/storage/disk/async_io_engine.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <future>  // NOLINT
+#include <memory>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * AsyncIOEngine issues positional page reads and writes on a file descriptor without blocking the caller.
+ *
+ * Every request is completed through the returned future, which becomes ready once the whole page has been
+ * transferred. Reads past the end of the file zero-fill the rest of the buffer. The buffer must stay valid until the
+ * future is ready. Requests are not ordered with respect to each other; a caller that needs a write to land before a
+ * read of the same buffer has to wait for the write first.
+ */
+class AsyncIOEngine {
+ public:
+  virtual ~AsyncIOEngine() = default;
+
+  /**
+   * Creates an engine for the given file. io_uring is used if it was requested and the kernel allows it, otherwise
+   * the engine falls back to a pool of threads doing blocking pread/pwrite.
+   * @param fd the file to read from and write to
+   * @param use_io_uring false to always use the thread pool
+   * @param queue_depth the maximum number of requests in flight, further submissions wait for a free slot
+   * @return the new engine
+   */
+  static std::unique_ptr<AsyncIOEngine> Create(int fd, bool use_io_uring = true,
+                                               size_t queue_depth = ASYNC_IO_QUEUE_DEPTH);
+
+  /**
+   * Submits a read of size bytes at offset into data.
+   * @return a future that becomes ready once data holds the bytes
+   */
+  virtual std::future<void> SubmitRead(char *data, size_t size, off_t offset) = 0;
+
+  /**
+   * Submits a write of size bytes of data to offset.
+   * @return a future that becomes ready once the bytes have been handed to the kernel
+   */
+  virtual std::future<void> SubmitWrite(const char *data, size_t size, off_t offset) = 0;
+
+  /** @return true if the requests go through io_uring */
+  virtual bool IsIOUring() const = 0;
+};
+
+}  // namespace bustub
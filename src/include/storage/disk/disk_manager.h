@@ -15,25 +15,47 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/async_io_engine.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread/pwrite on a file descriptor, so page I/Os issued by different threads run
+ * concurrently instead of sharing a stream position. Page writes are not synced one by one; SyncData makes all the
+ * writes so far durable and is called at the explicit sync points (flushing the whole buffer pool, shutdown).
+ *
+ * ReadPageAsync/WritePageAsync submit page I/O to an AsyncIOEngine (io_uring, or a thread pool where io_uring is
+ * not available) and return right away, so that callers can keep many page I/Os in flight.
+ *
+ * With direct I/O the database file is opened with O_DIRECT, so pages move straight between the device and the
+ * caller's memory without a copy in the OS page cache. Buffer pool frames are suitably aligned; pages in unaligned
+ * memory are transferred through an aligned bounce buffer (synchronously, for the asynchronous calls).
+ *
+ * Deallocated pages are recorded in a free page map, one bit per page, that is kept in a file next to the database
+ * file (foo.db -> foo.free). AllocatePage hands out the lowest free page before it grows the file, and freeing the
+ * last pages of the file truncates it, so the file does not keep growing under allocate/deallocate churn. Changes to
+ * the map are written through right away and become durable together with the pages, in SyncData.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param use_io_uring false to run asynchronous page I/O on the thread pool even if io_uring is available
+   * @param direct_io true to bypass the OS page cache for the database file, if the file system supports it
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool use_io_uring = true, bool direct_io = false);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -54,6 +76,33 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Starts writing a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay unchanged until the returned future is ready
+   * @return a future that becomes ready once the write is done
+   */
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Starts reading a page from the database file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the returned future is ready
+   * @return a future that becomes ready once page_data holds the page
+   */
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /** @return true if the database file was opened with O_DIRECT */
+  bool UsesDirectIO() const { return direct_io_; }
+
+  /** @return true if asynchronous page I/O goes through io_uring, false if it runs on the thread pool */
+  bool UsesIOUring() const { return io_engine_ != nullptr && io_engine_->IsIOUring(); }
+
+  /**
+   * Forces the pages written so far to stable storage.
+   */
+  void SyncData();
+
   /**
    * Append a log entry to the log file.
    * @param log_data raw log data
@@ -71,17 +120,24 @@ class DiskManager {
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk, reusing the lowest deallocated page if there is one.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage can hand it out again. Deallocating a page that is not allocated
+   * has no effect.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return true if the page was deallocated and has not been allocated again */
+  bool IsPageFree(page_id_t page_id);
+
+  /** @return the number of deallocated pages waiting to be reused */
+  size_t GetNumFreePages();
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +147,15 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of page reads, sync and async; tests and benchmarks count buffer pool misses with it */
+  int GetNumReads() const;
+
+  /** @return the number of times the database file was synced */
+  int GetNumSyncs() const;
+
+  /** @return the number of pages the database file holds, pages with larger ids have never been written */
+  int GetNumPages();
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -102,17 +167,40 @@ class DiskManager {
 
  private:
   int GetFileSize(const std::string &file_name);
+  // the page I/O itself, page_data is aligned if needed
+  void WritePageData(page_id_t page_id, const char *page_data);
+  void ReadPageData(page_id_t page_id, char *page_data);
+  // true if page_data can't be used for O_DIRECT I/O as is
+  bool NeedsBounce(const char *page_data) const;
+  // loads the free page map of the pages the db file holds, drops the entries past its end
+  void LoadFreePageMap();
+  // writes the byte of the free page map that holds the bit of page_id
+  void WriteFreePageMapByte(page_id_t page_id);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file, -1 after shutdown
+  int db_fd_;
+  // engine for the asynchronous page I/O on db_fd_
+  std::unique_ptr<AsyncIOEngine> io_engine_;
   std::string file_name_;
   std::atomic<page_id_t> next_page_id_;
+  // free page map, bit (page_id % 8) of byte (page_id / 8) is set if the page is free
+  std::string free_map_name_;
+  int free_map_fd_;
+  std::vector<uint8_t> free_map_;
+  size_t num_free_pages_;
+  // no byte of free_map_ below this one has a bit set
+  size_t free_map_hint_;
+  // protects next_page_id_ and the free page map
+  std::mutex alloc_latch_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_reads_;
+  std::atomic<int> num_syncs_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  bool direct_io_;
 };
 
 }  // namespace bustub
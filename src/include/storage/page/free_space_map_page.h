@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Free space map page of a table heap, see FreeSpaceMap. Like the hash table pages, it is the content of a page
+ * fetched from the buffer pool, reinterpret cast.
+ *
+ * Every entry holds a table page id and the free space of that page in units of FSM_UNIT bytes, rounded down (its
+ * category). The categories are the leaves of a binary max tree, so finding the first entry with enough room and
+ * updating an entry both take O(log CAPACITY) steps.
+ *
+ * Format (size in bytes):
+ * ---------------------------------------------------------------------------------------------------------
+ * | TableId (4) | NextPageId (4) | NumEntries (4) | PageId_1 (4) | ... | PageId_n (4) | Tree (2 * n) |
+ * ---------------------------------------------------------------------------------------------------------
+ *
+ * TableId is the first page id of the table that owns the map. Tree[1] is the root, the children of node i are
+ * 2i and 2i+1, and the category of entry i is leaf Tree[n + i].
+ */
+class FreeSpaceMapPage {
+ public:
+  /** Granularity of the free space kept in the map. */
+  static constexpr uint32_t FSM_UNIT = PAGE_SIZE / 256;
+  /** Number of entries a map page holds, a power of two that leaves room for the header. */
+  static constexpr uint32_t CAPACITY = [] {
+    uint32_t capacity = 1;
+    while ((2 * capacity) * (sizeof(page_id_t) + 2) + 3 * sizeof(uint32_t) <= PAGE_SIZE) {
+      capacity *= 2;
+    }
+    return capacity;
+  }();
+
+  /**
+   * Initialize an empty map page.
+   * @param table_id the first page id of the table that owns the map
+   */
+  void Init(page_id_t table_id);
+
+  /** @return the first page id of the table that owns the map */
+  page_id_t GetTableId() const { return table_id_; }
+
+  /** @return the page id of the next page of the map */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  /** Set the page id of the next page of the map. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the number of entries in this page */
+  uint32_t GetNumEntries() const { return num_entries_; }
+
+  /** @return true if no more entries fit into this page */
+  bool IsFull() const { return num_entries_ == CAPACITY; }
+
+  /** @return the table page id of the entry at index, INVALID_PAGE_ID if the entry was cleared */
+  page_id_t GetTablePageId(uint32_t index) const { return page_ids_[index]; }
+
+  /**
+   * Clears the entry at index, because its table page is no longer part of the table. The entry keeps its place.
+   * @param index the index of the entry
+   */
+  void Clear(uint32_t index) {
+    page_ids_[index] = INVALID_PAGE_ID;
+    SetFreeSpace(index, 0);
+  }
+
+  /** @return the largest category of the entries of this page */
+  uint8_t GetMaxCategory() const { return tree_[1]; }
+
+  /**
+   * Adds an entry at the end of the page, the page must not be full.
+   * @param table_page_id the table page of the entry
+   * @param free_space the free space of the table page in bytes
+   * @return the index of the entry
+   */
+  uint32_t Append(page_id_t table_page_id, uint32_t free_space);
+
+  /**
+   * Sets the free space of the entry at index.
+   * @param index the index of the entry
+   * @param free_space the free space of the table page in bytes
+   */
+  void SetFreeSpace(uint32_t index, uint32_t free_space);
+
+  /**
+   * Looks for a table page with at least size bytes of free space.
+   * @param size the number of bytes needed
+   * @return the index of the first such entry, or GetNumEntries() if there is none
+   */
+  uint32_t Find(uint32_t size) const;
+
+  /** @return the free space category that covers free_space bytes, rounded down */
+  static uint8_t ToCategory(uint32_t free_space) {
+    return static_cast<uint8_t>(free_space / FSM_UNIT > UINT8_MAX ? UINT8_MAX : free_space / FSM_UNIT);
+  }
+
+  /** @return the smallest category that guarantees size bytes of free space */
+  static uint32_t NeededCategory(uint32_t size) { return (size + FSM_UNIT - 1) / FSM_UNIT; }
+
+ private:
+  page_id_t table_id_;
+  page_id_t next_page_id_;
+  uint32_t num_entries_;
+  page_id_t page_ids_[CAPACITY];
+  uint8_t tree_[2 * CAPACITY];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE);
+
+}  // namespace bustub
@@ -38,12 +38,26 @@ namespace bustub {
  *
  *  Here '+' means concatenation.
  *
+ * A block page can also be laid out with fingerprints: it then holds FINGERPRINT_ARRAY_SIZE pairs, followed by a
+ * control byte for each of them with a 7 bit fingerprint of the hash of its key, so that a probe compares 16
+ * fingerprints at once and only compares the keys whose fingerprint matches.
+ *
+ *  -----------------------------------------------------------------------------------------------
+ * | KEY(1) + VALUE(1) | ... | KEY(n) + VALUE(n) | FINGERPRINT(1) | ... | FINGERPRINT(n) | PADDING
+ *  -----------------------------------------------------------------------------------------------
+ *
  */
 
  // HashTableBlockPage is just a page BufferPoolManager can control, and it stores occupied_/readable/array_
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBlockPage {
  public:
+  /** The bytes after the control bytes, a compare of 16 of them may read past the last one. */
+  static constexpr size_t FINGERPRINT_PADDING = 15;
+  /** The number of pairs of a block page laid out with fingerprints. */
+  static constexpr slot_offset_t FINGERPRINT_ARRAY_SIZE =
+      (PAGE_SIZE - 2 * ((BLOCK_ARRAY_SIZE - 1) / 8 + 1) - FINGERPRINT_PADDING) / (sizeof(MappingType) + 1);
+
   // Delete all constructor / destructor to ensure memory safety
   HashTableBlockPage() = delete;
 
@@ -101,7 +115,72 @@ class HashTableBlockPage {
    */
   bool IsReadable(slot_offset_t bucket_ind) const;
 
+  /**
+   * Reads the readable bits of up to 64 indexes at once, for walking over the readable indexes of a range.
+   *
+   * @param begin the first index to read
+   * @param end the index after the last one to read, the bits from there on are 0
+   * @return the bits of the indexes from begin on, the one of begin is the most significant
+   */
+  uint64_t ReadableBits(slot_offset_t begin, slot_offset_t end) const;
+
+  /**
+   * Finds the first index in a range that is not readable, i.e. a tombstone or never occupied.
+   *
+   * @param begin the first index to look at
+   * @param end the index after the last one to look at
+   * @return the first index that is not readable, end if there is none
+   */
+  slot_offset_t NextFree(slot_offset_t begin, slot_offset_t end) const;
+
+  /**
+   * Finds the first index in a range that was never occupied.
+   *
+   * @param begin the first index to look at
+   * @param end the index after the last one to look at
+   * @return the first index that is not occupied, end if there is none
+   */
+  slot_offset_t NextUnoccupied(slot_offset_t begin, slot_offset_t end) const;
+
+  /**
+   * Finds the first tombstone in a range.
+   *
+   * @param begin the first index to look at
+   * @param end the index after the last one to look at
+   * @return the first index that is occupied but not readable, end if there is none
+   */
+  slot_offset_t NextTombstone(slot_offset_t begin, slot_offset_t end) const;
+
+  /**
+   * Sets the fingerprint of an index of a block page laid out with fingerprints.
+   *
+   * @param bucket_ind index of the pair, below FINGERPRINT_ARRAY_SIZE
+   * @param fingerprint the fingerprint of the hash of its key, below 128
+   */
+  void SetFingerprint(slot_offset_t bucket_ind, uint8_t fingerprint);
+
+  /**
+   * Compares the fingerprints of up to 64 indexes of a block page laid out with fingerprints to one, 16 at a time.
+   * The bits of the indexes that are not readable are meaningless.
+   *
+   * @param begin the first index to compare
+   * @param end the index after the last one to compare, at most FINGERPRINT_ARRAY_SIZE; the bits from there on are 0
+   * @param fingerprint the fingerprint to look for
+   * @return the bits of the indexes from begin on that have the fingerprint, the one of begin is the most significant
+   */
+  uint64_t FingerprintBits(slot_offset_t begin, slot_offset_t end, uint8_t fingerprint) const;
+
  private:
+  /** @return the control bytes of a block page laid out with fingerprints */
+  const char *Fingerprints() const { return reinterpret_cast<const char *>(array_ + FINGERPRINT_ARRAY_SIZE); }
+
+  /**
+   * Finds the first index in a range whose bit is set in a combination of the bitmaps.
+   * @param combine makes the 64 bits of a word from those of occupied_ and readable_
+   */
+  template <typename Combine>
+  slot_offset_t FindIndex(slot_offset_t begin, slot_offset_t end, Combine &&combine) const;
+
   // Here std::atomic_char is a bit-map, for saving space.
   // occupied_.size() * 8 = BLOCK_ARRAY_SIZE
   std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
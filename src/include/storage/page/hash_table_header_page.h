@@ -31,10 +31,17 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
- * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
- * -------------------------------------------------------------
+ * Header format (size in byte):
+ * ---------------------------------------------------------------------------------------------
+ * | LSN (4) | Size (8) | PageId(4) | NextBlockIndex(8) | OldSize (8) | MovedBuckets (8) | NumPairs (8) |
+ * ---------------------------------------------------------------------------------------------
+ * | NumTombstones (8) | BlockPageIds
+ * ---------------------------------------------------------------------------------------------
+ *
+ * While a resize is under way, the table has two arrays of buckets: the OldSize buckets its pairs are moved from,
+ * whose block pages come first, and the Size buckets they are moved to. MovedBuckets of the old buckets have been
+ * moved. OldSize is 0 otherwise. NumPairs counts the pairs in the table, NumTombstones the buckets of the Size buckets
+ * whose pair was removed.
  */
 
 // HashTableHeaderPage is just a page BufferPoolManager can control.
@@ -52,6 +59,54 @@ class HashTableHeaderPage {
    */
   void SetSize(size_t size);
 
+  /**
+   * @return the number of buckets a resize under way moves the pairs from, 0 if there is none
+   */
+  size_t GetOldSize() const;
+
+  /**
+   * Sets the old size field of the hash table to old_size
+   *
+   * @param old_size the size for the old size field to be set to
+   */
+  void SetOldSize(size_t old_size);
+
+  /**
+   * @return the number of old buckets a resize under way has moved
+   */
+  size_t GetMovedBuckets() const;
+
+  /**
+   * Sets the moved buckets field of the hash table to moved_buckets
+   *
+   * @param moved_buckets the number for the moved buckets field to be set to
+   */
+  void SetMovedBuckets(size_t moved_buckets);
+
+  /**
+   * @return the number of key-value pairs in the hash table
+   */
+  size_t GetNumPairs() const;
+
+  /**
+   * Sets the number of pairs field of the hash table to num_pairs
+   *
+   * @param num_pairs the number for the number of pairs field to be set to
+   */
+  void SetNumPairs(size_t num_pairs);
+
+  /**
+   * @return the number of tombstones in the buckets of the hash table
+   */
+  size_t GetNumTombstones() const;
+
+  /**
+   * Sets the number of tombstones field of the hash table to num_tombstones
+   *
+   * @param num_tombstones the number for the number of tombstones field to be set to
+   */
+  void SetNumTombstones(size_t num_tombstones);
+
   /**
    * @return the page ID of this page
    */
@@ -96,11 +151,22 @@ class HashTableHeaderPage {
    */
   size_t NumBlocks();
 
+  /**
+   * Removes the first block page_ids, the ones after them move to the front
+   *
+   * @param count the number of page_ids to remove
+   */
+  void RemoveBlockPageIds(size_t count);
+
  private:
   __attribute__((unused)) lsn_t lsn_;
   __attribute__((unused)) size_t size_;
   __attribute__((unused)) page_id_t page_id_;
   __attribute__((unused)) size_t next_ind_;
+  __attribute__((unused)) size_t old_size_;
+  __attribute__((unused)) size_t moved_buckets_;
+  __attribute__((unused)) size_t num_pairs_;
+  __attribute__((unused)) size_t num_tombstones_;
   // The block_page_ids_ array maps block ids to page_id_t
   __attribute__((unused)) page_id_t block_page_ids_[0];
 };
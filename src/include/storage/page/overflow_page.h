@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Overflow page of a table heap. A tuple that does not fit into a table page keeps its first bytes in the table page
+ * and the rest in a chain of overflow pages, see TablePage. Like the hash table pages, it is the content of a page
+ * fetched from the buffer pool, reinterpret cast.
+ *
+ * Format (size in bytes):
+ * -----------------------------------------------
+ * | NextPageId (4) | Size (4) | Data (Size) ... |
+ * -----------------------------------------------
+ */
+class OverflowPage {
+ public:
+  /** Number of tuple bytes an overflow page holds. */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - sizeof(page_id_t) - sizeof(uint32_t);
+
+  /**
+   * Initialize the page with a piece of a tuple.
+   * @param data the bytes of the tuple
+   * @param size the number of bytes, at most CAPACITY
+   */
+  void Init(const char *data, uint32_t size) {
+    next_page_id_ = INVALID_PAGE_ID;
+    size_ = size;
+    memcpy(data_, data, size);
+  }
+
+  /** @return the page id of the next page of the chain */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  /** Set the page id of the next page of the chain. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the number of tuple bytes in this page */
+  uint32_t GetSize() const { return size_; }
+
+  /** @return the tuple bytes in this page */
+  const char *GetData() const { return data_; }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[CAPACITY];
+};
+
+static_assert(sizeof(OverflowPage) == PAGE_SIZE);
+
+}  // namespace bustub
@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_encoding.h
+//
+// Identification: src/include/storage/page/pax_encoding.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * How the minipage of a column in a sealed PaxPage is stored. Every encoded minipage starts at an 8 byte boundary.
+ *
+ *  PLAIN: the values one after the other, as in an unsealed page.
+ *  FRAME_OF_REFERENCE: | Base (8) | Width (4) | (4) | Codes |, a value is Base plus its code, codes are Width bits.
+ *  DICTIONARY: | Size (4) | Width (4) | Values (8 * Size) | Codes |, the values sorted, codes are Width bits.
+ *  RLE: | RunCount (4) | (4) | Values (8 * RunCount) | Ends (4 * RunCount) |, run i covers the slots before Ends[i].
+ *
+ * Codes are packed into 64 bit words, a code may span two words; a width of 0 means all codes are 0. Only integer
+ * columns (BOOLEAN, TINYINT, SMALLINT, INTEGER, BIGINT) are encoded, with their values as int64.
+ */
+enum class PaxEncoding : uint8_t { PLAIN = 0, FRAME_OF_REFERENCE, DICTIONARY, RLE };
+
+/**
+ * A condition on an integer column that a scan evaluates on the encoded minipage: the value is in [low_, high_], or
+ * with negate_ it is not. Null values never satisfy it.
+ */
+struct PaxPredicate {
+  /** The column of the condition, in the table's schema. */
+  uint32_t column_idx_;
+  int64_t low_;
+  int64_t high_;
+  bool negate_{false};
+};
+
+/**
+ * PaxColumnEncoder collects the statistics of the values of a column that go into a minipage, picks the smallest
+ * encoding for them and writes the minipage. Values are added one by one, so a caller can stop once the encoded
+ * page would no longer fit.
+ */
+class PaxColumnEncoder {
+ public:
+  /** The largest dictionary, larger ones are not considered. */
+  static constexpr uint32_t MAX_DICTIONARY_SIZE = 256;
+
+  /**
+   * @param length the length of a value
+   * @param is_integer false if the column is not an integer column, its minipage is always PLAIN
+   */
+  PaxColumnEncoder(uint32_t length, bool is_integer) : length_(length), is_integer_(is_integer) {}
+
+  /** Adds the value at src, length bytes. */
+  void Add(const char *src);
+
+  /** @return the encoding with the smallest minipage for the values added so far */
+  PaxEncoding GetEncoding() const;
+
+  /** @return the number of bytes of the minipage with GetEncoding(), a multiple of 8 */
+  uint32_t GetEncodedSize() const { return GetEncodedSize(GetEncoding()); }
+
+  /**
+   * Writes the minipage. The values must be the ones that were added, in the same order.
+   * @param values the first value
+   * @param stride the distance between two values
+   * @param[out] dest where the minipage goes, GetEncodedSize() bytes
+   */
+  void Write(const char *values, size_t stride, char *dest) const;
+
+ private:
+  uint32_t GetEncodedSize(PaxEncoding encoding) const;
+
+  /** @return the number of bits a code needs for the values 0 to max_code */
+  static uint32_t CodeWidth(uint64_t max_code) {
+    return max_code == 0 ? 0 : 64 - static_cast<uint32_t>(__builtin_clzll(max_code));
+  }
+
+  uint32_t length_;
+  bool is_integer_;
+  uint32_t count_{0};
+  int64_t min_{0};
+  int64_t max_{0};
+  uint32_t run_count_{0};
+  int64_t last_{0};
+  /** The distinct values, as long as there are at most MAX_DICTIONARY_SIZE of them. */
+  std::set<int64_t> distinct_;
+  bool dictionary_full_{false};
+};
+
+/** PaxMinipage reads the encoded minipages of a sealed PaxPage, see PaxEncoding. */
+class PaxMinipage {
+ public:
+  /** @return the integer value of length bytes at src */
+  static int64_t LoadInteger(const char *src, uint32_t length) {
+    switch (length) {
+      case 1:
+        return *reinterpret_cast<const int8_t *>(src);
+      case 2: {
+        int16_t value;
+        memcpy(&value, src, sizeof(value));
+        return value;
+      }
+      case 4: {
+        int32_t value;
+        memcpy(&value, src, sizeof(value));
+        return value;
+      }
+      default: {
+        int64_t value;
+        memcpy(&value, src, sizeof(value));
+        return value;
+      }
+    }
+  }
+
+  /**
+   * Reads the value of a slot.
+   * @param encoding the encoding of the minipage
+   * @param minipage the minipage
+   * @param length the length of a value
+   * @param slot_num the slot
+   * @param[out] dest where the value goes, length bytes
+   */
+  static void GetValue(PaxEncoding encoding, const char *minipage, uint32_t length, uint32_t slot_num, char *dest);
+
+  /**
+   * Reads the values of some slots into a column of rows.
+   * @param encoding the encoding of the minipage
+   * @param minipage the minipage
+   * @param length the length of a value
+   * @param slots the slots, in ascending order
+   * @param[out] rows where the value of the first slot goes, the others follow at row_length bytes each
+   * @param row_length the distance between two rows
+   */
+  static void Gather(PaxEncoding encoding, const char *minipage, uint32_t length, const std::vector<uint32_t> &slots,
+                     char *rows, uint32_t row_length);
+
+  /**
+   * Drops the slots whose value does not satisfy a predicate, without decoding the values.
+   * @param encoding the encoding of the minipage
+   * @param minipage the minipage
+   * @param length the length of a value
+   * @param predicate the condition
+   * @param[in,out] slots the slots, in ascending order
+   */
+  static void Filter(PaxEncoding encoding, const char *minipage, uint32_t length, const PaxPredicate &predicate,
+                     std::vector<uint32_t> *slots);
+};
+
+}  // namespace bustub
@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.h
+//
+// Identification: src/include/storage/page/pax_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/page/pax_encoding.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PaxLayout places the columns of a schema in a PaxPage: how many tuples a page holds, and where the minipage of
+ * every column starts. The schema must have fixed-width columns only.
+ */
+class PaxLayout {
+ public:
+  /** Lays out the columns of schema. */
+  explicit PaxLayout(const Schema &schema);
+
+  /** @return the number of tuples a page holds */
+  uint32_t GetCapacity() const { return capacity_; }
+
+  /** @return the number of columns */
+  uint32_t GetColumnCount() const { return static_cast<uint32_t>(lengths_.size()); }
+
+  /** @return the length of a value of the column */
+  uint32_t GetColumnLength(uint32_t column_idx) const { return lengths_[column_idx]; }
+
+  /** @return the offset of the column in a tuple */
+  uint32_t GetTupleOffset(uint32_t column_idx) const { return tuple_offsets_[column_idx]; }
+
+  /** @return the offset of the minipage of the column in a page */
+  uint32_t GetMinipageOffset(uint32_t column_idx) const { return minipage_offsets_[column_idx]; }
+
+  /** @return the length of a whole tuple */
+  uint32_t GetTupleLength() const { return tuple_length_; }
+
+  /** @return true if the column holds integers, which a sealed page may encode */
+  bool IsInteger(uint32_t column_idx) const { return is_integer_[column_idx]; }
+
+  /** @return an encoder for every column, with no values */
+  std::vector<PaxColumnEncoder> CreateEncoders() const;
+
+ private:
+  uint32_t capacity_;
+  uint32_t tuple_length_;
+  std::vector<uint32_t> lengths_;
+  std::vector<bool> is_integer_;
+  std::vector<uint32_t> tuple_offsets_;
+  std::vector<uint32_t> minipage_offsets_;
+};
+
+/**
+ * PAX page format: the tuples of the page are stored column by column. Every column has a minipage that holds the
+ * values of that column for all the slots of the page, one after the other, so a scan of a few columns only touches
+ * their minipages. The slots are filled in order; a bitmap marks the ones that hold a live tuple.
+ *
+ * A page that will take no more inserts can be sealed: every minipage is then re-encoded with the encoding that
+ * makes it smallest (see PaxEncoding), and a directory after the bitmap records where each one starts and how it is
+ * encoded. Deletes still only clear bits of the bitmap. A page can also be created sealed, with as many tuples as
+ * fit encoded, up to MAX_SEALED_TUPLES.
+ *
+ *  ------------------------------------------------------------------------------------------------
+ *  | HEADER | LIVE BITMAP | MINIPAGE OF COLUMN 0 | MINIPAGE OF COLUMN 1 | ... | MINIPAGE OF COLUMN n |
+ *  ------------------------------------------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  --------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| TupleCount (4) | LiveCount (4) | Flags (4) |
+ *  --------------------------------------------------------------------------------------------
+ *
+ *  Sealed page format, the bitmap has a bit for every slot in use:
+ *  ----------------------------------------------------------------------------------------------
+ *  | HEADER | LIVE BITMAP | DIRECTORY | ENCODED MINIPAGE OF COLUMN 0 | ... | ENCODED MINIPAGE OF COLUMN n |
+ *  ----------------------------------------------------------------------------------------------
+ *  with a directory entry of | Encoding (1) | (3) | Offset (4) | for every column, at an 8 byte boundary.
+ *
+ * TupleCount is the number of slots in use, live or deleted; LiveCount the number of live tuples. Where the bitmap
+ * and the minipages of an unsealed page are depends on the schema, see PaxLayout.
+ */
+class PaxPage : public Page {
+ public:
+  static constexpr size_t SIZE_PAX_PAGE_HEADER = 28;
+  /** The most tuples a sealed page holds. */
+  static constexpr uint32_t MAX_SEALED_TUPLES = PAGE_SIZE;
+
+  /**
+   * Initialize an empty page.
+   * @param layout the layout of the table
+   * @param page_id the page ID of this page
+   * @param prev_page_id the previous page ID
+   */
+  void Init(const PaxLayout &layout, page_id_t page_id, page_id_t prev_page_id);
+
+  /**
+   * Initialize a sealed page with live tuples.
+   * @param layout the layout of the table
+   * @param page_id the page ID of this page
+   * @param prev_page_id the previous page ID
+   * @param rows the tuples, one after the other
+   * @param tuple_count the number of tuples
+   * @param encoders the encoders the tuples were added to, GetSealedSize() must fit into a page
+   */
+  void InitSealed(const PaxLayout &layout, page_id_t page_id, page_id_t prev_page_id, const char *rows,
+                  uint32_t tuple_count, const std::vector<PaxColumnEncoder> &encoders);
+
+  /**
+   * Seals the page, if encoding it makes any of its minipages smaller. The page takes no more inserts afterwards.
+   * @param layout the layout of the table
+   * @return false if the page was left as it is
+   */
+  bool Seal(const PaxLayout &layout);
+
+  /**
+   * @param layout the layout of the table
+   * @param encoders the encoders the tuples of a page were added to
+   * @param tuple_count the number of tuples
+   * @return the number of bytes of a sealed page with the tuples
+   */
+  static uint32_t GetSealedSize(const PaxLayout &layout, const std::vector<PaxColumnEncoder> &encoders,
+                                uint32_t tuple_count);
+
+  /** @return the page ID of this page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the page ID of the previous page */
+  page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+
+  /** @return the page ID of the next page */
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Set the page id of the next page. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /** @return the number of slots in use, live or deleted */
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+
+  /** @return the number of live tuples */
+  uint32_t GetLiveCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_LIVE_COUNT); }
+
+  /** @return true if the page is sealed */
+  bool IsSealed() { return (*reinterpret_cast<uint32_t *>(GetData() + OFFSET_FLAGS) & FLAG_SEALED) != 0; }
+
+  /** @return true if the slot holds a live tuple */
+  bool IsLive(uint32_t slot_num) {
+    return (static_cast<uint8_t>(GetData()[SIZE_PAX_PAGE_HEADER + slot_num / 8]) >> (slot_num % 8) & 1) != 0;
+  }
+
+  /**
+   * Insert a tuple into the first free slot.
+   * @param layout the layout of the table
+   * @param tuple the tuple to insert, of the table's schema
+   * @param[out] rid the rid of the inserted tuple
+   * @return false if the page is full or sealed
+   */
+  bool InsertTuple(const PaxLayout &layout, const Tuple &tuple, RID *rid);
+
+  /**
+   * Delete a tuple, its slot can be reused.
+   * @param rid the rid of the tuple
+   * @return false if the slot holds no live tuple
+   */
+  bool DeleteTuple(const RID &rid);
+
+  /**
+   * Read a tuple, the columns are gathered from their minipages.
+   * @param layout the layout of the table
+   * @param rid the rid of the tuple
+   * @param[out] tuple the tuple
+   * @return false if the slot holds no live tuple
+   */
+  bool GetTuple(const PaxLayout &layout, const RID &rid, Tuple *tuple);
+
+  /**
+   * Reads the values of a column for some slots into a column of rows.
+   * @param layout the layout of the table
+   * @param column_idx the column
+   * @param slots the slots, in ascending order
+   * @param[out] rows where the value of the first slot goes, the others follow at row_length bytes each
+   * @param row_length the distance between two rows
+   */
+  void ReadColumn(const PaxLayout &layout, uint32_t column_idx, const std::vector<uint32_t> &slots, char *rows,
+                  uint32_t row_length);
+
+  /**
+   * Drops the slots whose tuple does not satisfy a predicate, evaluated on the minipage as it is encoded.
+   * @param layout the layout of the table
+   * @param predicate the condition, on an integer column
+   * @param[in,out] slots the slots, in ascending order
+   */
+  void Filter(const PaxLayout &layout, const PaxPredicate &predicate, std::vector<uint32_t> *slots);
+
+  /** @return the encoding of the minipage of a column */
+  PaxEncoding GetEncoding(const PaxLayout &layout, uint32_t column_idx) {
+    PaxEncoding encoding;
+    GetMinipage(layout, column_idx, &encoding);
+    return encoding;
+  }
+
+ private:
+  static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 16;
+  static constexpr size_t OFFSET_LIVE_COUNT = 20;
+  static constexpr size_t OFFSET_FLAGS = 24;
+  static constexpr uint32_t FLAG_SEALED = 1;
+  static constexpr size_t SIZE_DIRECTORY_ENTRY = 8;
+
+  /** @return the offset of the directory of a sealed page with tuple_count slots */
+  static uint32_t GetDirectoryOffset(uint32_t tuple_count) {
+    return (SIZE_PAX_PAGE_HEADER + (tuple_count + 7) / 8 + 7) / 8 * 8;
+  }
+
+  /** @return the minipage of a column, and its encoding */
+  const char *GetMinipage(const PaxLayout &layout, uint32_t column_idx, PaxEncoding *encoding);
+
+  /**
+   * Writes the directory and the encoded minipages of a sealed page with GetTupleCount() slots.
+   * @param layout the layout of the table
+   * @param encoders the encoders the values were added to
+   * @param columns for every column, its first value and the distance between two values
+   * @param[out] data the page to write to
+   */
+  void WriteSealed(const PaxLayout &layout, const std::vector<PaxColumnEncoder> &encoders,
+                   const std::vector<std::pair<const char *, size_t>> &columns, char *data);
+
+  void SetFlags(uint32_t flags) { memcpy(GetData() + OFFSET_FLAGS, &flags, sizeof(uint32_t)); }
+
+  void SetPrevPageId(page_id_t prev_page_id) {
+    memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
+  }
+
+  void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
+
+  void SetLiveCount(uint32_t live_count) { memcpy(GetData() + OFFSET_LIVE_COUNT, &live_count, sizeof(uint32_t)); }
+
+  void SetLive(uint32_t slot_num, bool live) {
+    auto &byte = reinterpret_cast<uint8_t &>(GetData()[SIZE_PAX_PAGE_HEADER + slot_num / 8]);
+    byte = live ? byte | (1U << (slot_num % 8)) : byte & ~(1U << (slot_num % 8));
+  }
+};
+
+}  // namespace bustub
@@ -21,6 +21,7 @@
 #include "storage/table/tuple.h"
 
 static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
+static constexpr uint64_t OVERFLOW_MASK = (1U << (8 * sizeof(uint32_t) - 2));
 
 namespace bustub {
 
@@ -36,13 +37,32 @@ namespace bustub {
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  ----------------------------------------------------------------------------
+ *  | TupleCount (4) | FreeSpaceMapPageId (4) | FreeSlot (4) | DeadSpace (4) |
+ *  ----------------------------------------------------------------------------
+ *  ---------------------------------------------------
+ *  | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  ---------------------------------------------------
+ *
+ *  FreeSpaceMapPageId is only used in the first page of a table, it points to the table's free space map.
+ *
+ *  The empty slots (size 0) form a list: FreeSlot is the first one, and the offset field of an empty slot holds the
+ *  next one, so inserts find a slot to reuse in O(1). Deleting a tuple leaves its bytes where they are and adds them
+ *  to DeadSpace; only once an insert or update needs more contiguous space than the free space offers, the page is
+ *  compacted and the dead space becomes free space again.
  *
+ *  A tuple too large for a page is stored with its tail in a chain of OverflowPages. The page keeps the first bytes
+ *  of the tuple, followed by the first page of the chain (4) and the size of the whole tuple (4), and the overflow
+ *  flag is set in the size of its slot. Reading such a tuple only reads the bytes in the page; the tuple loads its
+ *  tail from the chain when a column needs it (see Tuple).
  */
 class TablePage : public Page {
  public:
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 36;
+  static constexpr size_t SIZE_TUPLE = 8;
+  /** Size of the reference to the overflow pages at the end of a tuple with overflow pages. */
+  static constexpr size_t SIZE_OVERFLOW_POINTER = 8;
+
   /**
    * Initialize the TablePage header.
    * @param page_id the page ID of this table page
@@ -72,9 +92,34 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
   }
 
+  /** @return the page ID of the first page of the table's free space map, valid in the first page of a table */
+  page_id_t GetFreeSpaceMapPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_FSM_PAGE_ID); }
+
+  /** Set the page id of the first page of the table's free space map. */
+  void SetFreeSpaceMapPageId(page_id_t fsm_page_id) {
+    memcpy(GetData() + OFFSET_FSM_PAGE_ID, &fsm_page_id, sizeof(page_id_t));
+  }
+
+  /** @return the number of bytes available to a new tuple and its slot, counting the space compaction reclaims */
+  uint32_t GetFreeSpaceRemaining() { return GetContiguousFreeSpace() + GetDeadSpace(); }
+
+  /**
+   * Compacts the page now rather than on demand, and drops the empty slots at the end of the slot array. Tuples whose
+   * delete is not applied yet keep their space.
+   * @return the number of bytes that became free space
+   */
+  uint32_t Vacuum();
+
+  /** @return true if no slot holds a tuple, not even a deleted one */
+  bool IsEmpty();
+
+  /** Makes the page refuse inserts from now on, it is about to be unlinked from its table. It must be empty. */
+  void Retire() { SetFreeSpacePointer(SIZE_TABLE_PAGE_HEADER + SIZE_TUPLE * GetTupleCount()); }
+
   /**
    * Insert a tuple into the table.
-   * @param tuple tuple to insert
+   * @param tuple tuple to insert; if its tail is in overflow pages, only its loaded bytes and a reference to the
+   * overflow pages are stored
    * @param[out] rid rid of the inserted tuple
    * @param txn transaction performing the insert
    * @param lock_manager the lock manager
@@ -83,6 +128,22 @@ class TablePage : public Page {
    */
   bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
 
+  /**
+   * Append a tuple in a new slot, for bulk loads (see TableHeap::BulkInsert). Unlike InsertTuple, this does not look
+   * for a free slot, lock the tuple or log the insert; log the whole page with LogPageImage instead.
+   * @param tuple tuple to append
+   * @param[out] rid rid of the appended tuple
+   * @return true if the append is successful (i.e. there is enough space)
+   */
+  bool AppendTuple(const Tuple &tuple, RID *rid);
+
+  /**
+   * Log the current content of the page.
+   * @param txn transaction that wrote the page
+   * @param log_manager the log manager
+   */
+  void LogPageImage(Transaction *txn, LogManager *log_manager);
+
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
    * @param rid rid of the tuple to mark as deleted
@@ -113,15 +174,40 @@ class TablePage : public Page {
   void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
 
   /**
-   * Read a tuple from a table.
+   * Read a tuple from a table, with all of its bytes: its overflow pages are read too.
    * @param rid rid of the tuple to read
-   * @param[out] tuple the tuple that was read
+   * @param[out] tuple the tuple that was read, it must know the buffer pool if it may have overflow pages
    * @param txn transaction performing the read
    * @param lock_manager the lock manager
    * @return true if the read is successful (i.e. the tuple exists)
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Read a tuple from a table without copying it. The tuple points into this page, so it is only valid while the
+   * page stays pinned and latched.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTupleView(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * @param rid rid of a tuple in this page, deleted or not
+   * @return the first overflow page of the tuple, INVALID_PAGE_ID if it has none
+   */
+  page_id_t GetOverflowPageId(const RID &rid);
+
+  /**
+   * @param tuple a tuple to be stored, see InsertTuple
+   * @return the number of bytes the tuple takes in a page
+   */
+  static uint32_t GetStoredSize(const Tuple &tuple) {
+    return tuple.overflow_page_id_ == INVALID_PAGE_ID ? tuple.size_ : tuple.loaded_size_ + SIZE_OVERFLOW_POINTER;
+  }
+
   /** @return the rid of the first tuple in this page */
 
   /**
@@ -140,14 +226,17 @@ class TablePage : public Page {
  private:
   static_assert(sizeof(page_id_t) == 4);
 
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;  // Naming things is hard.
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_FSM_PAGE_ID = 24;
+  static constexpr size_t OFFSET_FREE_SLOT = 28;
+  static constexpr size_t OFFSET_DEAD_SPACE = 32;
+  static constexpr size_t OFFSET_TUPLE_OFFSET = 36;  // Naming things is hard.
+  static constexpr size_t OFFSET_TUPLE_SIZE = 40;
+  /** Marks the end of the free slot list. */
+  static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
 
   /** @return pointer to the end of the current free space, see header comment */
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
@@ -166,10 +255,26 @@ class TablePage : public Page {
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
+  /** @return the space between the slot array and the tuples */
+  uint32_t GetContiguousFreeSpace() {
     return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
   }
 
+  /** @return the first empty slot, INVALID_SLOT if there is none */
+  uint32_t GetFreeSlot() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SLOT); }
+
+  /** Set the first empty slot. */
+  void SetFreeSlot(uint32_t slot_num) { memcpy(GetData() + OFFSET_FREE_SLOT, &slot_num, sizeof(uint32_t)); }
+
+  /** @return the number of bytes taken by deleted tuples that have not been compacted away yet */
+  uint32_t GetDeadSpace() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_DEAD_SPACE); }
+
+  /** Set the number of bytes taken by deleted tuples. */
+  void SetDeadSpace(uint32_t dead_space) { memcpy(GetData() + OFFSET_DEAD_SPACE, &dead_space, sizeof(uint32_t)); }
+
+  /** Moves the tuples to the end of the page, so that the dead space becomes part of the free space. */
+  void Compact();
+
   /** @return tuple offset at slot slot_num */
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
@@ -180,16 +285,37 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
   }
 
-  /** @return tuple size at slot slot_num */
+  /** @return tuple size at slot slot_num, with the deleted flag but without the overflow flag */
   uint32_t GetTupleSize(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
+    return static_cast<uint32_t>(*reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num) &
+                                 ~OVERFLOW_MASK);
   }
 
-  /** Set tuple size at slot slot_num. */
+  /** Set tuple size at slot slot_num, keeping the overflow flag. */
   void SetTupleSize(uint32_t slot_num, uint32_t size) {
-    memcpy(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, &size, sizeof(uint32_t));
+    uint32_t value = size | (*reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num) &
+                             static_cast<uint32_t>(OVERFLOW_MASK));
+    memcpy(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, &value, sizeof(uint32_t));
   }
 
+  /** @return true if the tuple at slot slot_num has overflow pages */
+  bool HasOverflow(uint32_t slot_num) {
+    return static_cast<bool>(*reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num) &
+                             OVERFLOW_MASK);
+  }
+
+  /** Set or clear the overflow flag of slot slot_num. */
+  void SetOverflowFlag(uint32_t slot_num, bool has_overflow) {
+    uint32_t value = GetTupleSize(slot_num) | (has_overflow ? static_cast<uint32_t>(OVERFLOW_MASK) : 0);
+    memcpy(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, &value, sizeof(uint32_t));
+  }
+
+  /** Copies a tuple to be stored to offset, see GetStoredSize. */
+  void WriteTuple(uint32_t offset, const Tuple &tuple);
+
+  /** Points tuple at the tuple in slot slot_num, which must hold one. */
+  void ReadTuple(uint32_t slot_num, Tuple *tuple);
+
   /** @return true if the tuple is deleted or empty */
   static bool IsDeleted(uint32_t tuple_size) { return static_cast<bool>(tuple_size & DELETE_MASK) || tuple_size == 0; }
 
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks the approximate free space of every page of a table heap, so that an insert can go straight to
+ * a page with enough room instead of walking the page chain.
+ *
+ * The map is a chain of FreeSpaceMapPages, the first one is recorded in the first page of the table. Its entries are
+ * in the order of the table's page chain, so the last entry is the last page of the table. The map is only a hint:
+ * entries are updated after the table page changed, and may be stale after a crash. An insert that does not fit
+ * after all corrects the entry, and table pages the map does not know about are picked up from the page chain when
+ * the map is loaded.
+ *
+ * The map is loaded lazily by its first use. Since that reads table pages, callers must not hold a table page latch
+ * while they call into the map.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Creates the free space map of a table.
+   * @param buffer_pool_manager the buffer pool manager
+   * @param table_id the first page id of the table
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t table_id);
+
+  /**
+   * Looks for a table page with room for size bytes.
+   * @param size the number of bytes needed
+   * @return the first table page with at least size bytes of free space, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t size);
+
+  /**
+   * Records the free space of a table page.
+   * @param page_id the table page
+   * @param free_space the free space of the page in bytes
+   */
+  void Update(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Records a page that was appended to the table.
+   * @param page_id the new last page of the table
+   * @param free_space the free space of the page in bytes
+   * @return false if the map page for the entry could not be created
+   */
+  bool Append(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Forgets a page that was unlinked from the table.
+   * @param page_id the page
+   */
+  void Remove(page_id_t page_id);
+
+  /** @return the last page of the table, as far as the map knows */
+  page_id_t GetLastPageId();
+
+  /** @return the number of table pages in the map */
+  size_t GetNumPages();
+
+ private:
+  // reads the map, or starts one, and picks up the table pages it misses. Requires latch_.
+  void Load();
+  // Append with latch_ held
+  bool AppendLocked(page_id_t page_id, uint32_t free_space);
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t table_id_;
+  std::mutex latch_;
+  bool loaded_{false};
+  // the pages of the map, in chain order, and the largest category in each of them
+  std::vector<page_id_t> map_page_ids_;
+  std::vector<uint8_t> max_categories_;
+  // table page -> (index into map_page_ids_, index of the entry in that map page)
+  std::unordered_map<page_id_t, std::pair<size_t, uint32_t>> locations_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
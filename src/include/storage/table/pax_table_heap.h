@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_heap.h
+//
+// Identification: src/include/storage/table/pax_table_heap.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "storage/page/pax_page.h"
+#include "storage/table/pax_table_iterator.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PaxTableHeap is a table stored in PaxPages: a doubly-linked list of pages that keep their tuples column by column,
+ * so a scan that needs a few columns of a wide table only reads theirs (see PaxTableIterator).
+ *
+ * It is meant for analytic tables that are loaded and then scanned. Unlike TableHeap it takes no locks and writes no
+ * log records, and its schema must have fixed-width columns only. Inserts append to the last page; slots of deleted
+ * tuples are only reused on that page.
+ *
+ * Once the last page is full, it is sealed, which compresses its integer columns (see PaxPage), and a new page is
+ * appended. BulkInsert() instead writes sealed pages directly, each packed with as many tuples as fit encoded.
+ */
+class PaxTableHeap {
+ public:
+  /**
+   * Create a table heap. (create table)
+   * @param buffer_pool_manager the buffer pool manager
+   * @param schema the schema of the tuples, fixed-width columns only
+   */
+  PaxTableHeap(BufferPoolManager *buffer_pool_manager, const Schema &schema);
+
+  /**
+   * Open a table heap. (open table)
+   * @param buffer_pool_manager the buffer pool manager
+   * @param schema the schema the table was created with
+   * @param first_page_id the id of the first page
+   */
+  PaxTableHeap(BufferPoolManager *buffer_pool_manager, const Schema &schema, page_id_t first_page_id);
+
+  /**
+   * Insert a tuple into the table.
+   * @param tuple tuple to insert, of the table's schema
+   * @param[out] rid the rid of the inserted tuple
+   * @return true iff the insert is successful
+   */
+  bool InsertTuple(const Tuple &tuple, RID *rid);
+
+  /**
+   * Append tuples to the end of the table in sealed pages. The last page is sealed first.
+   * @param tuples tuples to insert, of the table's schema
+   * @param[out] rids if not nullptr, the rids of the inserted tuples are appended to it, in order
+   * @return true iff all the tuples were inserted
+   */
+  bool BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids);
+
+  /**
+   * Delete a tuple from the table.
+   * @param rid rid of the tuple to delete
+   * @return true iff the delete is successful (i.e the tuple exists)
+   */
+  bool DeleteTuple(const RID &rid);
+
+  /**
+   * Read a whole tuple from the table.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple output variable for the tuple
+   * @return true if the read was successful (i.e. the tuple exists)
+   */
+  bool GetTuple(const RID &rid, Tuple *tuple);
+
+  /**
+   * @param column_ids the columns to read, the tuples of the scan have these columns in this order
+   * @param predicate if not nullptr, the scan only returns the tuples that satisfy it (see PaxTableIterator)
+   * @return the begin iterator of this table
+   */
+  PaxTableIterator Begin(const std::vector<uint32_t> &column_ids, const PaxPredicate *predicate = nullptr);
+
+  /** @return the end iterator of this table */
+  PaxTableIterator End();
+
+  /** @return the id of the first page of this table */
+  page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  /** @return the schema of the tuples */
+  const Schema &GetSchema() const { return schema_; }
+
+  /** @return the layout of the pages */
+  const PaxLayout &GetLayout() const { return layout_; }
+
+  /** @return the buffer pool manager of this table */
+  BufferPoolManager *GetBufferPoolManager() { return buffer_pool_manager_; }
+
+ private:
+
+  BufferPoolManager *buffer_pool_manager_;
+  Schema schema_;
+  PaxLayout layout_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  /** Serializes inserts, which go to the last page. */
+  std::mutex extend_latch_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_iterator.h
+//
+// Identification: src/include/storage/table/pax_table_iterator.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "storage/page/pax_encoding.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+class PaxTableHeap;
+
+/**
+ * PaxTableIterator scans a PaxTableHeap and returns only the columns it was asked for. When it moves to a page, it
+ * copies the projected minipages of the live tuples into rows of its own, under one read latch, and unpins the page
+ * again; the other columns of the page are not touched. The current tuple is a view into those rows with the
+ * projected schema (see GetSchema()), valid until the iterator moves.
+ *
+ * Given a predicate, the iterator evaluates it on the page before it copies anything, on the minipage as it is encoded,
+ * and only returns the tuples that satisfy it. The predicate is owned by the caller and must outlive the iterator.
+ */
+class PaxTableIterator {
+ public:
+  /**
+   * @param table_heap the table to scan
+   * @param column_ids the columns to return
+   * @param page_id the page to start at, INVALID_PAGE_ID for the end iterator
+   * @param predicate if not nullptr, only the tuples that satisfy it are returned
+   */
+  PaxTableIterator(PaxTableHeap *table_heap, const std::vector<uint32_t> &column_ids, page_id_t page_id,
+                   const PaxPredicate *predicate = nullptr);
+
+  PaxTableIterator(const PaxTableIterator &other) = delete;
+
+  PaxTableIterator &operator=(const PaxTableIterator &other) = delete;
+
+  PaxTableIterator(PaxTableIterator &&other) = default;
+
+  ~PaxTableIterator() = default;
+
+  inline bool operator==(const PaxTableIterator &itr) const { return tuple_.rid_.Get() == itr.tuple_.rid_.Get(); }
+
+  inline bool operator!=(const PaxTableIterator &itr) const { return !(*this == itr); }
+
+  const Tuple &operator*() { return tuple_; }
+
+  Tuple *operator->() { return &tuple_; }
+
+  PaxTableIterator &operator++();
+
+  /** @return the schema of the tuples the iterator returns, the projected columns */
+  const Schema *GetSchema() const { return &schema_; }
+
+ private:
+  /** Moves to the first live tuple at or after page_id, or to the end. */
+  void LoadPage(page_id_t page_id);
+
+  /** Points the current tuple at the current row. */
+  void SetTuple();
+
+  PaxTableHeap *table_heap_;
+  std::vector<uint32_t> column_ids_;
+  Schema schema_;
+  const PaxPredicate *predicate_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** The live slots of the current page that satisfy the predicate. */
+  std::vector<uint32_t> slots_;
+  /** The projected columns of the live tuples of the current page, one row per tuple. */
+  std::vector<char> rows_;
+  size_t pos_{0};
+  Tuple tuple_;
+};
+
+}  // namespace bustub
@@ -12,22 +12,42 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages. Inserts find a page with enough room through the table's FreeSpaceMap.
+ * Every tuple too large for a page has a chain of overflow pages of its own, which goes away with the tuple.
+ * A table can keep a ZoneMap, which lets scans with a condition on a column skip pages.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
+  /** What a vacuum reclaimed. */
+  struct VacuumResult {
+    /** The pages that were compacted or lost empty slots. */
+    uint32_t compacted_pages_{0};
+    /** The empty pages that were unlinked from the table. */
+    uint32_t freed_pages_{0};
+    /** The bytes that became free space in the pages of the table, plus the size of the unlinked pages. */
+    uint64_t reclaimed_bytes_{0};
+  };
+
   ~TableHeap() = default;
 
   /**
@@ -40,6 +60,19 @@ class TableHeap {
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
             page_id_t first_page_id);
 
+  /**
+   * Create a table heap and its zone map without a transaction. (open table) The zone map is not stored with the
+   * table, so it is built from the tuples in the pages, see CreateZoneMap.
+   * @param buffer_pool_manager the buffer pool manager
+   * @param lock_manager the lock manager
+   * @param log_manager the log manager
+   * @param first_page_id the id of the first page
+   * @param schema the schema of the tuples
+   * @param txn the transaction reading the table to build the zone map
+   */
+  TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
+            page_id_t first_page_id, const Schema &schema, Transaction *txn);
+
   /**
    * Create a table heap with a transaction. (create table)
    * @param buffer_pool_manager the buffer pool manager
@@ -51,7 +84,8 @@ class TableHeap {
             Transaction *txn);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large for a page, all but its first OVERFLOW_INLINE_SIZE
+   * bytes go to a chain of overflow pages (see TablePage).
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
@@ -59,6 +93,18 @@ class TableHeap {
    */
   bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn);
 
+  /**
+   * Append tuples to the end of the table in bulk. The tuples are packed into the last page and fresh pages in a
+   * tight loop, and with logging enabled every page written is logged once as a whole instead of once per tuple.
+   * This is meant for loading data: the tuples are neither locked nor added to the transaction's write set, so an
+   * abort does not remove them.
+   * @param tuples tuples to insert
+   * @param[out] rids if not nullptr, the rids of the inserted tuples are appended to it, in order
+   * @param txn the transaction performing the insert
+   * @return true iff all the tuples were inserted
+   */
+  bool BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param rid resource id of the tuple of delete
@@ -68,7 +114,8 @@ class TableHeap {
   bool MarkDelete(const RID &rid, Transaction *txn);  // for delete
 
   /**
-   * if the new tuple is too large to fit in the old page, return false (will delete and insert)
+   * if the new tuple is too large to fit in the old page, return false (will delete and insert). The overflow pages
+   * of the old tuple are freed, the old tuple kept for a rollback is loaded completely first.
    * @param tuple new tuple
    * @param rid rid of the old tuple
    * @param txn transaction performing the update
@@ -99,8 +146,17 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn the transaction performing the scan
+   * @param ring if not nullptr, the pages of the scan are fetched through this ring (see BufferRing)
+   * @param readahead_window the number of pages to prefetch ahead of the scan, 0 to not prefetch (see TableIterator)
+   * @param zero_copy if true, the iterator hands out views into the pages instead of copies (see TableIterator)
+   * @param predicate if not nullptr and the table has a zone map, the iterator skips the pages that cannot hold a
+   * tuple that satisfies the predicate; tuples on the pages it reads are not filtered (see TableIterator)
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferRing *ring = nullptr, uint32_t readahead_window = 0,
+                      bool zero_copy = false, const ZoneMap::Predicate *predicate = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -108,11 +164,103 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the free space map of this table */
+  FreeSpaceMap *GetFreeSpaceMap() { return free_space_map_.get(); }
+
+  /**
+   * Creates the zone map of the table from the tuples it holds. Nobody may modify the table meanwhile.
+   * @param schema the schema of the tuples
+   * @param txn the transaction reading the table
+   */
+  void CreateZoneMap(const Schema &schema, Transaction *txn);
+
+  /** @return the zone map of this table, nullptr if it has none */
+  ZoneMap *GetZoneMap() { return zone_map_.get(); }
+
+  /**
+   * Reclaims the space of deleted tuples. Every page is compacted and loses the empty slots at its end, and the pages
+   * left empty are unlinked from the page chain, except for the first and the last page. The pages are visited one
+   * after the other, latching at most the page, its predecessor and its successor at a time, so readers and writers
+   * of the rest of the table go on. Neither the compaction nor the unlinking is logged.
+   *
+   * A scan that is on an unlinked page, or read the link to it just before, still finds its way on, since the page
+   * keeps its link to the next page. So the unlinked pages are only deallocated by a later vacuum, once every scan
+   * that started before they were unlinked has finished and nobody has them pinned. The calling thread must not hold
+   * a page of the table latched, e.g. through a zero-copy iterator.
+   * @return what was reclaimed
+   */
+  VacuumResult Vacuum();
+
  private:
+  /** Number of bytes of a tuple with overflow pages that stay in the table page. */
+  static constexpr uint32_t OVERFLOW_INLINE_SIZE = PAGE_SIZE / 16;
+
+  /** @return true if the tuple does not fit into a page and needs overflow pages */
+  static bool NeedsOverflow(const Tuple &tuple) {
+    return tuple.size_ + TablePage::SIZE_TUPLE + TablePage::SIZE_TABLE_PAGE_HEADER > PAGE_SIZE;
+  }
+
+  /**
+   * Writes all but the first OVERFLOW_INLINE_SIZE bytes of a tuple to a new chain of overflow pages.
+   * @param tuple the tuple
+   * @param[out] stored the tuple as it is to be stored, it points into the data of tuple
+   * @return false if the overflow pages could not be created
+   */
+  bool WriteOverflow(const Tuple &tuple, Tuple *stored);
+
+  /** Deletes a chain of overflow pages, starting at page_id. */
+  void FreeOverflow(page_id_t page_id);
+
+  /**
+   * Inserts a tuple as it is to be stored, see InsertTuple.
+   * @return true iff the insert is successful
+   */
+  bool InsertStored(const Tuple &tuple, RID *rid, Transaction *txn);
+
+  /**
+   * Appends a new page to the table and inserts the tuple into it. Requires extend_latch_.
+   * @return true iff the insert is successful
+   */
+  bool ExtendAndInsert(const Tuple &tuple, RID *rid, Transaction *txn);
+
+  /**
+   * Fetches and write latches the last page of the table. The free space map may not know the last pages yet (it is
+   * not logged), so this follows the chain to its real end. Requires extend_latch_.
+   * @param[out] missed_pages the pages the map did not know about and their free space, to be added to the map
+   * @return the last page, nullptr if it could not be fetched
+   */
+  TablePage *FetchLastPage(std::vector<std::pair<page_id_t, uint32_t>> *missed_pages);
+
+  /**
+   * Registers a scan that starts now, it must be ended with LeaveScan.
+   * @return the epoch the scan started in
+   */
+  uint64_t EnterScan();
+
+  /** Registers one more scan that started in the given epoch, e.g. the copy of an iterator. */
+  void EnterScan(uint64_t epoch);
+
+  /** Ends a scan that started in the given epoch. */
+  void LeaveScan(uint64_t epoch);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  std::unique_ptr<ZoneMap> zone_map_;
+  /** Serializes appending pages to the table. */
+  std::mutex extend_latch_;
+  /** Serializes vacuums, and protects unlinked_pages_. */
+  std::mutex vacuum_latch_;
+  /** The pages vacuums unlinked and that are not deallocated yet, with the epoch they were unlinked in. */
+  std::vector<std::pair<page_id_t, uint64_t>> unlinked_pages_;
+  /** Protects scan_epoch_ and active_scans_. */
+  std::mutex scan_latch_;
+  /** The current epoch, every vacuum that unlinks pages ends one. */
+  uint64_t scan_epoch_{0};
+  /** The epochs the scans in progress started in, one entry per scan. */
+  std::multiset<uint64_t> active_scans_;
 };
 
 }  // namespace bustub
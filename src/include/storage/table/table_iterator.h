@@ -14,24 +14,58 @@
 
 #include <cassert>
 
+#include "buffer/buffer_ring.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ * If the iterator is given a BufferRing, the pages it moves to are fetched through the ring, so a scan of a large
+ * table does not evict the rest of the buffer pool. The ring is owned by the caller and must outlive the iterator.
+ *
+ * With a readahead window of N pages, the iterator asks the buffer pool to prefetch the N pages following the page
+ * it moves to, and tops the window up once half of it has been consumed. The heap chain can only be followed one
+ * page at a time, so the window guesses that the chain continues with consecutive page ids, which is what
+ * appending to a table produces. The guess is only made while the link of the page the iterator moved to is the next
+ * page id; otherwise only the page the link points to is prefetched. With a ring, the prefetched pages go into the
+ * frames of the ring, and the window is cut down to leave one of them to the page the iterator is on.
+ *
+ * By default the current tuple is a copy, and the iterator unpins the page once the tuple is copied, so any number
+ * of iterators can be open on a small buffer pool. A zero-copy iterator instead keeps the page it is positioned on
+ * pinned and read latched, and hands out a view into the page, so a scan step does not go through the buffer pool,
+ * allocate or copy the tuple. The view is only valid until the iterator moves or is released; Release() drops the
+ * latch while the caller does other work, and the next increment picks up from the current position. The page stays
+ * pinned until the iterator moves off it, so every open zero-copy iterator takes a frame. While a zero-copy iterator
+ * holds the latch, the thread must not modify the table. A copy of an iterator owns a copy of its tuple and pins
+ * nothing until it is incremented.
+ *
+ * Given a zone map predicate, the iterator asks the table's ZoneMap before it moves to a page, and goes past the pages
+ * that cannot hold a tuple that satisfies it without fetching them. The tuples of the pages it does read are all
+ * returned; filtering them is up to the caller. The predicate is owned by the caller and must outlive the iterator.
  */
 class TableIterator {
   friend class Cursor;
+  friend class TableHeap;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring = nullptr,
+                uint32_t readahead_window = 0, bool zero_copy = false,
+                const ZoneMap::Predicate *predicate = nullptr);
 
-  ~TableIterator() { delete tuple_; }
+  TableIterator(const TableIterator &other);
+
+  TableIterator(TableIterator &&other) noexcept;
+
+  TableIterator &operator=(const TableIterator &other);
+
+  ~TableIterator();
 
   inline bool operator==(const TableIterator &itr) const { return tuple_->rid_.Get() == itr.tuple_->rid_.Get(); }
 
@@ -45,10 +79,54 @@ class TableIterator {
 
   TableIterator operator++(int);
 
+  /**
+   * Drops the latch a zero-copy iterator holds on its page, the current tuple is no longer valid afterwards. The page
+   * stays pinned, so the next increment continues where the iterator stopped.
+   */
+  void Release();
+
  private:
+  /** Reads the tuple at the current rid from the current page, which must be latched. */
+  void LoadTuple();
+
+  /** Unlatches and unpins the current page, if there is one. */
+  void ReleasePage();
+
+  /** Ends the scan of the table once the iterator is done with it, see TableHeap::Vacuum. */
+  void LeaveScan();
+
+  /** Makes tuple_ an owning copy of tuple. */
+  void CopyTuple(const Tuple &tuple);
+
+  /**
+   * Prefetches the readahead window if the scan is getting close to its end.
+   * @param page_id the page the scan has moved to
+   * @param next_page_id the page that follows it in the heap chain
+   */
+  void ReadAhead(page_id_t page_id, page_id_t next_page_id);
+
+  /** @return the first page from page_id on that the zone map predicate does not skip */
+  page_id_t SkipPages(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  BufferRing *ring_;
+  /** Number of pages to prefetch ahead of the scan, 0 to not prefetch. */
+  uint32_t readahead_window_;
+  /** All page ids below this one have been prefetched already. */
+  page_id_t readahead_end_{INVALID_PAGE_ID};
+  /** If true, tuple_ is a view into the page instead of a copy. */
+  bool zero_copy_;
+  /** The pages that cannot hold a tuple satisfying this are skipped, nullptr to read all pages. */
+  const ZoneMap::Predicate *predicate_;
+  /** The pinned page the iterator is positioned on, nullptr if it does not hold one. */
+  TablePage *page_{nullptr};
+  /** True while the iterator holds the read latch of page_. */
+  bool latched_{false};
+  /** True while the iterator is registered as a scan of the table, which started in scan_epoch_. */
+  bool in_scan_{false};
+  uint64_t scan_epoch_{0};
 };
 
 }  // namespace bustub
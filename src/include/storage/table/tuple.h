@@ -21,11 +21,19 @@
 
 namespace bustub {
 
+class BufferPoolManager;
+
 /**
  * Tuple format:
  * ---------------------------------------------------------------------
  * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
  * ---------------------------------------------------------------------
+ *
+ * A tuple read from a table may have its tail in overflow pages (see TablePage). A zero-copy view of it (see
+ * TableIterator) only has the bytes in the table page at first; the rest is read from the overflow chain as far as a
+ * column access needs it, or completely by GetData(). The chain is only safe to read while the table page is latched,
+ * a delete or update frees it right after, so a tuple that outlives the latch -- one returned by TableHeap::GetTuple,
+ * a copying scan or a copy -- has all of its bytes loaded.
  */
 class Tuple {
   friend class TablePage;
@@ -34,6 +42,10 @@ class Tuple {
 
   friend class TableIterator;
 
+  friend class PaxPage;
+
+  friend class PaxTableIterator;
+
  public:
   // Default constructor (to create a dummy tuple)
   Tuple() = default;
@@ -66,8 +78,13 @@ class Tuple {
   // return RID of current tuple
   inline RID GetRid() const { return rid_; }
 
-  // Get the address of this tuple in the table's backing store
-  inline char *GetData() const { return data_; }
+  // Get the address of this tuple in the table's backing store, loading all of it
+  inline char *GetData() const {
+    if (overflow_page_id_ != INVALID_PAGE_ID) {
+      LoadOverflow(size_);
+    }
+    return data_;
+  }
 
   // Get length of the tuple, including varchar legth
   inline uint32_t GetLength() const { return size_; }
@@ -89,10 +106,25 @@ class Tuple {
   // Get the starting storage address of specific column
   const char *GetDataPtr(const Schema *schema, uint32_t column_idx) const;
 
-  bool allocated_{false};  // is allocated?
-  RID rid_{};              // if pointing to the table heap, the rid is valid
+  // the number of bytes of data_ that are loaded
+  uint32_t GetLoadedSize() const { return overflow_page_id_ == INVALID_PAGE_ID ? size_ : loaded_size_; }
+
+  // read the overflow chain until at least the first end bytes are loaded
+  void LoadOverflow(uint32_t end) const;
+
+  // turn a tuple that points into a page into one that owns its data (deep copy of the loaded bytes)
+  void Materialize() const;
+
+  mutable bool allocated_{false};  // is allocated?
+  RID rid_{};                      // if pointing to the table heap, the rid is valid
   uint32_t size_{0};
-  char *data_{nullptr};
+  mutable char *data_{nullptr};
+  // the next overflow page to read, INVALID_PAGE_ID once all of the tuple is loaded
+  mutable page_id_t overflow_page_id_{INVALID_PAGE_ID};
+  // while overflow pages are left to read, the number of bytes loaded
+  mutable uint32_t loaded_size_{0};
+  // the buffer pool to read the overflow pages from
+  BufferPoolManager *buffer_pool_manager_{nullptr};
 };
 
 }  // namespace bustub
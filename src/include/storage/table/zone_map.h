@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ZoneMap keeps a summary of every fixed-width column for every page of a table heap: the smallest and the largest
+ * value, and the number of nulls. A scan with a condition on a column checks the summaries and skips the pages that
+ * cannot hold a matching tuple, without fetching them.
+ *
+ * A summary only ever grows: inserts and updates widen it before they return, deletes leave it alone. So it may be
+ * wider than the tuples in the page, but never narrower, and skipping a page is always safe. The map also records
+ * the order of the table's page chain, which is the order in which the pages were appended, so a scan can get from
+ * a skipped page to the one after it. Pages the map does not know are never skipped.
+ *
+ * The map lives in memory only, nothing of it is written to the table's pages. It is built from the table when the
+ * table is created, and again from the tuples in the pages when the table is opened with its schema; TableHeap keeps
+ * it up to date in between.
+ */
+class ZoneMap {
+ public:
+  /** Summary of a column over the tuples that were stored in a page. */
+  struct ColumnSummary {
+    /** The smallest and the largest value that is not null, null values if there was none. */
+    Value min_;
+    Value max_;
+    /** The number of null values, deletes don't count it down. */
+    uint32_t null_count_{0};
+  };
+
+  /** A condition on one column of the tuples a scan is looking for. */
+  struct Predicate {
+    /** The column of the condition. */
+    uint32_t column_idx_;
+    /** Returns false if no tuple of a page with the given summary of the column can satisfy the condition. */
+    std::function<bool(const ColumnSummary &summary)> may_match_;
+  };
+
+  /**
+   * Creates an empty zone map.
+   * @param schema the schema of the table
+   */
+  explicit ZoneMap(const Schema &schema);
+
+  /**
+   * Records a page that was appended to the table, with an empty summary. Must be called before the page is linked
+   * into the page chain, so a scan never finds the page without knowing it.
+   * @param page_id the new last page of the table
+   */
+  void AppendPage(page_id_t page_id);
+
+  /**
+   * Forgets a page that was unlinked from the page chain.
+   * @param page_id the page
+   */
+  void RemovePage(page_id_t page_id);
+
+  /**
+   * Widens the summaries of a page by the values of a tuple.
+   * @param page_id the page the tuple is stored in
+   * @param tuple the tuple
+   */
+  void Add(page_id_t page_id, const Tuple &tuple);
+
+  /**
+   * Reads the summary of a column of a page.
+   * @param page_id the page
+   * @param column_idx the column
+   * @param[out] summary the summary
+   * @return false if the map does not know the page or does not summarize the column
+   */
+  bool GetSummary(page_id_t page_id, uint32_t column_idx, ColumnSummary *summary);
+
+  /**
+   * Finds the first page, starting at page_id and following the page chain, that may hold a tuple that satisfies
+   * the predicate.
+   * @param page_id the page to start at
+   * @param predicate the condition of the scan
+   * @return the first page not to be skipped, INVALID_PAGE_ID if the chain ends before
+   */
+  page_id_t SkipPages(page_id_t page_id, const Predicate &predicate);
+
+  /** @return true if the map keeps summaries of the column */
+  bool IsSummarized(uint32_t column_idx) const {
+    return column_idx < schema_.GetColumnCount() && schema_.GetColumn(column_idx).IsInlined();
+  }
+
+ private:
+  /** The summaries of a page, one per column of the schema; columns that are not summarized stay empty. */
+  struct PageSummary {
+    /** The position of the page in page_ids_. */
+    size_t index_;
+    std::vector<ColumnSummary> columns_;
+  };
+
+  Schema schema_;
+  std::mutex latch_;
+  /** The pages of the table, in chain order; INVALID_PAGE_ID where a page was removed. */
+  std::vector<page_id_t> page_ids_;
+  std::unordered_map<page_id_t, PageSummary> pages_;
+};
+
+}  // namespace bustub
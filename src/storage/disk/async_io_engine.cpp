@@ -0,0 +1,380 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_engine.cpp
+//
+// Identification: src/storage/disk/async_io_engine.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_io_engine.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BUSTUB_HAVE_IO_URING 1
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** A single read or write and the promise to fulfil once it is done. */
+struct IORequest {
+  IORequest(bool is_write, char *data, size_t size, off_t offset)
+      : is_write_(is_write), data_(data), size_(size), offset_(offset) {}
+
+  bool is_write_;
+  char *data_;
+  size_t size_;
+  off_t offset_;
+  /** Bytes transferred so far, short transfers are continued. */
+  size_t done_{0};
+  std::promise<void> promise_;
+};
+
+/**
+ * Fallback engine: a fixed number of threads that take requests from a queue and run blocking pread/pwrite.
+ */
+class ThreadPoolEngine : public AsyncIOEngine {
+ public:
+  ThreadPoolEngine(int fd, size_t queue_depth) : fd_(fd), queue_depth_(queue_depth) {
+    for (int i = 0; i < ASYNC_IO_THREADS; i++) {
+      workers_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ~ThreadPoolEngine() override {
+    {
+      std::scoped_lock lock(latch_);
+      running_ = false;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  std::future<void> SubmitRead(char *data, size_t size, off_t offset) override {
+    return Submit(new IORequest(false, data, size, offset));
+  }
+
+  std::future<void> SubmitWrite(const char *data, size_t size, off_t offset) override {
+    return Submit(new IORequest(true, const_cast<char *>(data), size, offset));
+  }
+
+  bool IsIOUring() const override { return false; }
+
+ private:
+  std::future<void> Submit(IORequest *request) {
+    auto future = request->promise_.get_future();
+    std::unique_lock lock(latch_);
+    slot_cv_.wait(lock, [this] { return queue_.size() < queue_depth_; });
+    queue_.push_back(request);
+    cv_.notify_one();
+    return future;
+  }
+
+  void Work() {
+    std::unique_lock lock(latch_);
+    while (true) {
+      cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+      // Drain the queue before stopping, nobody must be left waiting on a future.
+      if (queue_.empty()) {
+        return;
+      }
+      IORequest *request = queue_.front();
+      queue_.pop_front();
+      slot_cv_.notify_one();
+      lock.unlock();
+      Run(request);
+      lock.lock();
+    }
+  }
+
+  void Run(IORequest *request) {
+    while (request->done_ < request->size_) {
+      char *data = request->data_ + request->done_;
+      size_t size = request->size_ - request->done_;
+      off_t offset = request->offset_ + request->done_;
+      ssize_t rc = request->is_write_ ? pwrite(fd_, data, size, offset) : pread(fd_, data, size, offset);
+      if (rc < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rc <= 0) {
+        LOG_DEBUG("I/O error in async %s", request->is_write_ ? "write" : "read");
+        break;
+      }
+      request->done_ += rc;
+    }
+    if (!request->is_write_ && request->done_ < request->size_) {
+      memset(request->data_ + request->done_, 0, request->size_ - request->done_);
+    }
+    request->promise_.set_value();
+    delete request;
+  }
+
+  int fd_;
+  size_t queue_depth_;
+  std::vector<std::thread> workers_;
+  std::deque<IORequest *> queue_;
+  bool running_{true};
+  std::mutex latch_;
+  /** Wakes up workers when requests are queued or on shutdown. */
+  std::condition_variable cv_;
+  /** Wakes up submitters when the queue has room again. */
+  std::condition_variable slot_cv_;
+};
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/**
+ * io_uring engine, driven through the raw system calls. Submitters fill submission queue entries under a latch and
+ * enter the kernel once per request; a reaper thread waits for completions, continues short transfers and fulfils
+ * the promises. The number of requests in flight is capped at the completion queue size, so completions are never
+ * dropped.
+ */
+class IOUringEngine : public AsyncIOEngine {
+ public:
+  /** @return the engine, nullptr if io_uring is not available (old kernel, seccomp, ...) */
+  static std::unique_ptr<IOUringEngine> Create(int fd, size_t queue_depth) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    // IORING_OP_READ/WRITE came with the same kernel (5.6) as this feature flag.
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      close(ring_fd);
+      return nullptr;
+    }
+    auto engine = std::unique_ptr<IOUringEngine>(new IOUringEngine(fd, ring_fd, params));
+    if (!engine->Map()) {
+      return nullptr;
+    }
+    engine->reaper_ = std::thread([engine = engine.get()] { engine->Reap(); });
+    return engine;
+  }
+
+  ~IOUringEngine() override {
+    if (reaper_.joinable()) {
+      {
+        std::unique_lock lock(latch_);
+        running_ = false;
+        // Wait for everything in flight, then wake the reaper up with a no-op so it sees running_.
+        slot_cv_.wait(lock, [this] { return in_flight_ == 0; });
+        io_uring_sqe *sqe = NextSqe();
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        PushSqe();
+      }
+      reaper_.join();
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd_);
+  }
+
+  std::future<void> SubmitRead(char *data, size_t size, off_t offset) override {
+    return Submit(new IORequest(false, data, size, offset));
+  }
+
+  std::future<void> SubmitWrite(const char *data, size_t size, off_t offset) override {
+    return Submit(new IORequest(true, const_cast<char *>(data), size, offset));
+  }
+
+  bool IsIOUring() const override { return true; }
+
+ private:
+  IOUringEngine(int fd, int ring_fd, const io_uring_params &params) : fd_(fd), ring_fd_(ring_fd), params_(params) {}
+
+  bool Map() {
+    sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                  ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params_.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+    auto *sq = static_cast<char *>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params_.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params_.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params_.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params_.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params_.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params_.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params_.cq_off.cqes);
+    return true;
+  }
+
+  std::future<void> Submit(IORequest *request) {
+    auto future = request->promise_.get_future();
+    std::unique_lock lock(latch_);
+    slot_cv_.wait(lock, [this] { return in_flight_ < params_.cq_entries; });
+    in_flight_++;
+    Prepare(request);
+    return future;
+  }
+
+  /** Fills a submission queue entry for the rest of request and submits it. Requires latch_. */
+  void Prepare(IORequest *request) {
+    io_uring_sqe *sqe = NextSqe();
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(request->data_ + request->done_);
+    sqe->len = static_cast<uint32_t>(request->size_ - request->done_);
+    sqe->off = static_cast<uint64_t>(request->offset_ + request->done_);
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    PushSqe();
+  }
+
+  /** @return the next free submission queue entry, zeroed. Requires latch_. */
+  io_uring_sqe *NextSqe() {
+    unsigned tail = *sq_tail_;
+    auto *sqe = static_cast<io_uring_sqe *>(sqes_) + (tail & sq_mask_);
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+  }
+
+  /** Publishes the entry returned by NextSqe and hands it to the kernel. Requires latch_. */
+  void PushSqe() {
+    unsigned tail = *sq_tail_;
+    sq_array_[tail & sq_mask_] = tail & sq_mask_;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    // Without SQPOLL the kernel consumes the entry during this call, so the submission queue never fills up.
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0 && errno == EINTR) {
+    }
+  }
+
+  void Reap() {
+    while (true) {
+      if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+        LOG_DEBUG("io_uring_enter failed while waiting for completions");
+      }
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      std::vector<std::pair<IORequest *, int>> completions;
+      for (; head != tail; head++) {
+        io_uring_cqe &cqe = cqes_[head & cq_mask_];
+        completions.emplace_back(reinterpret_cast<IORequest *>(cqe.user_data), cqe.res);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+      for (auto [request, res] : completions) {
+        if (request == nullptr) {
+          return;
+        }
+        Complete(request, res);
+      }
+    }
+  }
+
+  void Complete(IORequest *request, int res) {
+    if (res == -EINTR || res == -EAGAIN || (res > 0 && request->done_ + res < request->size_)) {
+      // Continue the transfer where it stopped, the request keeps its slot.
+      request->done_ += std::max(res, 0);
+      std::scoped_lock lock(latch_);
+      Prepare(request);
+      return;
+    }
+    if (res < 0) {
+      LOG_DEBUG("I/O error in async %s: %s", request->is_write_ ? "write" : "read", strerror(-res));
+    } else {
+      request->done_ += res;
+    }
+    if (!request->is_write_ && request->done_ < request->size_) {
+      memset(request->data_ + request->done_, 0, request->size_ - request->done_);
+    }
+    request->promise_.set_value();
+    delete request;
+    {
+      std::scoped_lock lock(latch_);
+      in_flight_--;
+    }
+    slot_cv_.notify_all();
+  }
+
+  int fd_;
+  int ring_fd_;
+  io_uring_params params_;
+  void *sq_ring_{MAP_FAILED};
+  void *cq_ring_{MAP_FAILED};
+  void *sqes_{MAP_FAILED};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+  std::thread reaper_;
+  /** Protects the submission queue, in_flight_ and running_. */
+  std::mutex latch_;
+  /** Wakes up submitters when a request completes. */
+  std::condition_variable slot_cv_;
+  unsigned in_flight_{0};
+  bool running_{true};
+};
+
+#endif
+
+}  // namespace
+
+std::unique_ptr<AsyncIOEngine> AsyncIOEngine::Create(int fd, bool use_io_uring, size_t queue_depth) {
+#ifdef BUSTUB_HAVE_IO_URING
+  if (use_io_uring) {
+    auto engine = IOUringEngine::Create(fd, queue_depth);
+    if (engine != nullptr) {
+      return engine;
+    }
+    LOG_DEBUG("io_uring is not available, falling back to the thread pool");
+  }
+#endif
+  return std::make_unique<ThreadPoolEngine>(fd, queue_depth);
+}
+
+}  // namespace bustub
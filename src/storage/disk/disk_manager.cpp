@@ -10,8 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -24,18 +29,41 @@ namespace bustub {
 
 static char *buffer_used;
 
+/** With O_DIRECT, the memory of every page transfer has to be aligned to the logical block size of the device. */
+static constexpr uintptr_t DIRECT_IO_ALIGNMENT = 4096;
+
+/** A page sized buffer that satisfies DIRECT_IO_ALIGNMENT, for callers that hand in unaligned memory. */
+struct BouncePage {
+  BouncePage() : data_(static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE))) {}
+  ~BouncePage() { std::free(data_); }
+  char *data_;
+};
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool use_io_uring, bool direct_io)
+    : db_fd_(-1),
+      file_name_(db_file),
+      next_page_id_(0),
+      free_map_fd_(-1),
+      num_free_pages_(0),
+      free_map_hint_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      num_reads_(0),
+      num_syncs_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      direct_io_(false) {
   std::string::size_type n = file_name_.find('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  free_map_name_ = file_name_.substr(0, n) + ".free";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -48,24 +76,89 @@ DiskManager::DiskManager(const std::string &db_file)
     log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   }
 
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // create the file if it does not exist
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    if (!direct_io_) {
+      // e.g. tmpfs does not support O_DIRECT
+      LOG_DEBUG("can't open db file with O_DIRECT, falling back to buffered I/O");
+    }
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file");
+  } else {
+    io_engine_ = AsyncIOEngine::Create(db_fd_, use_io_uring);
+    LoadFreePageMap();
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  io_engine_.reset();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (free_map_fd_ >= 0) {
+    close(free_map_fd_);
+  }
+}
+
+void DiskManager::LoadFreePageMap() {
+  // Pages past the end of the db file have never been written, so allocation continues from there.
+  next_page_id_ = GetNumPages();
+  free_map_fd_ = open(free_map_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (free_map_fd_ < 0) {
+    LOG_DEBUG("can't open free page map, deallocated pages won't be reused after a restart");
+  }
+  free_map_.assign((next_page_id_ + 7) / 8, 0);
+  if (free_map_fd_ >= 0 && !free_map_.empty()) {
+    ssize_t bytes = pread(free_map_fd_, free_map_.data(), free_map_.size(), 0);
+    if (bytes < 0) {
+      LOG_DEBUG("I/O error while reading free page map");
+      bytes = 0;
+    }
+    memset(free_map_.data() + bytes, 0, free_map_.size() - bytes);
+  }
+  // A map left behind by an earlier, larger file may have bits set for pages that were truncated away.
+  if (next_page_id_ % 8 != 0) {
+    free_map_.back() &= static_cast<uint8_t>((1U << (next_page_id_ % 8)) - 1);
+  }
+  for (auto byte : free_map_) {
+    num_free_pages_ += __builtin_popcount(byte);
+  }
+  if (free_map_fd_ >= 0) {
+    if (ftruncate(free_map_fd_, 0) != 0 ||
+        pwrite(free_map_fd_, free_map_.data(), free_map_.size(), 0) != static_cast<ssize_t>(free_map_.size())) {
+      LOG_DEBUG("I/O error while writing free page map");
+    }
+  }
+}
+
+void DiskManager::WriteFreePageMapByte(page_id_t page_id) {
+  if (free_map_fd_ >= 0 && pwrite(free_map_fd_, &free_map_[page_id / 8], 1, page_id / 8) != 1) {
+    LOG_DEBUG("I/O error while writing free page map");
+  }
+}
+
 /**
- * Close all file streams
+ * Sync and close all files
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
+  // waits for the asynchronous I/O still in flight
+  io_engine_.reset();
+  if (db_fd_ >= 0) {
+    SyncData();
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (free_map_fd_ >= 0) {
+    close(free_map_fd_);
+    free_map_fd_ = -1;
+  }
   log_io_.close();
 }
 
@@ -73,40 +166,109 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
+  if (NeedsBounce(page_data)) {
+    BouncePage bounce;
+    memcpy(bounce.data_, page_data, PAGE_SIZE);
+    WritePageData(page_id, bounce.data_);
+  } else {
+    WritePageData(page_id, page_data);
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+}
+
+void DiskManager::WritePageData(page_id_t page_id, const char *page_data) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  ssize_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    // check for I/O error
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  // durability is up to the next SyncData
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
+  num_reads_ += 1;
+  if (NeedsBounce(page_data)) {
+    BouncePage bounce;
+    ReadPageData(page_id, bounce.data_);
+    memcpy(page_data, bounce.data_, PAGE_SIZE);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    ReadPageData(page_id, page_data);
+  }
+}
+
+void DiskManager::ReadPageData(page_id_t page_id, char *page_data) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  ssize_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
     }
+    // check for I/O error, or the end of the file
+    if (rc <= 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Submit the write of the specified page to the async I/O engine
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  if (NeedsBounce(page_data)) {
+    // the bounce buffer would have to outlive the call, unaligned memory takes the synchronous path instead
+    WritePage(page_id, page_data);
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future();
+  }
+  num_writes_ += 1;
+  return io_engine_->SubmitWrite(page_data, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+}
+
+/**
+ * Submit the read of the specified page to the async I/O engine
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (NeedsBounce(page_data)) {
+    ReadPage(page_id, page_data);
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future();
+  }
+  num_reads_ += 1;
+  return io_engine_->SubmitRead(page_data, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+}
+
+bool DiskManager::NeedsBounce(const char *page_data) const {
+  return direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0;
+}
+
+/**
+ * Make all the page writes so far durable
+ */
+void DiskManager::SyncData() {
+  num_syncs_ += 1;
+  if (fdatasync(db_fd_) != 0 || (free_map_fd_ >= 0 && fdatasync(free_map_fd_) != 0)) {
+    LOG_DEBUG("I/O error while syncing");
   }
 }
 
@@ -171,14 +333,83 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
  * Allocate new page (operations like create index/table)
  * For now just keep an increasing counter
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  std::scoped_lock latch(alloc_latch_);
+  if (num_free_pages_ == 0) {
+    return next_page_id_++;
+  }
+  // Reuse the lowest free page, that keeps the live pages packed at the start of the file.
+  while (free_map_[free_map_hint_] == 0) {
+    free_map_hint_++;
+  }
+  uint8_t &byte = free_map_[free_map_hint_];
+  page_id_t page_id = static_cast<page_id_t>(free_map_hint_ * 8 + __builtin_ctz(byte));
+  byte &= static_cast<uint8_t>(byte - 1);
+  num_free_pages_--;
+  WriteFreePageMapByte(page_id);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page is marked in the free page map, freeing the last pages of the file shrinks it instead.
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock latch(alloc_latch_);
+  if (page_id < 0 || page_id >= next_page_id_) {
+    return;
+  }
+  const auto index = static_cast<size_t>(page_id) / 8;
+  const auto mask = static_cast<uint8_t>(1U << (page_id % 8));
+  if (index >= free_map_.size()) {
+    free_map_.resize(index + 1, 0);
+  }
+  if ((free_map_[index] & mask) != 0) {
+    return;
+  }
+  free_map_[index] |= mask;
+  num_free_pages_++;
+  free_map_hint_ = std::min(free_map_hint_, index);
+
+  if (page_id != next_page_id_ - 1) {
+    WriteFreePageMapByte(page_id);
+    return;
+  }
+  // The file ends in free pages: drop them from the map and cut them off the file.
+  page_id_t end = next_page_id_;
+  while (end > 0 && (free_map_[(end - 1) / 8] & (1U << ((end - 1) % 8))) != 0) {
+    end--;
+    free_map_[end / 8] &= static_cast<uint8_t>(~(1U << (end % 8)));
+    num_free_pages_--;
+  }
+  next_page_id_ = end;
+  free_map_.resize((end + 7) / 8);
+  if (free_map_hint_ > free_map_.size()) {
+    free_map_hint_ = free_map_.size();
+  }
+  if (free_map_fd_ >= 0 && ftruncate(free_map_fd_, free_map_.size()) != 0) {
+    LOG_DEBUG("I/O error while truncating free page map");
+  }
+  if (end % 8 != 0) {
+    WriteFreePageMapByte(end - 1);
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0 && stat_buf.st_size > static_cast<off_t>(end) * PAGE_SIZE &&
+      ftruncate(db_fd_, static_cast<off_t>(end) * PAGE_SIZE) != 0) {
+    LOG_DEBUG("I/O error while truncating db file");
+  }
+}
+
+bool DiskManager::IsPageFree(page_id_t page_id) {
+  std::scoped_lock latch(alloc_latch_);
+  const auto index = static_cast<size_t>(page_id) / 8;
+  return page_id >= 0 && index < free_map_.size() && (free_map_[index] & (1U << (page_id % 8))) != 0;
+}
+
+size_t DiskManager::GetNumFreePages() {
+  std::scoped_lock latch(alloc_latch_);
+  return num_free_pages_;
+}
 
 /**
  * Returns number of flushes made so far
@@ -190,6 +421,24 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 int DiskManager::GetNumWrites() const { return num_writes_; }
 
+/**
+ * Returns number of page reads made so far
+ */
+int DiskManager::GetNumReads() const { return num_reads_; }
+
+/**
+ * Returns number of db file syncs made so far
+ */
+int DiskManager::GetNumSyncs() const { return num_syncs_; }
+
+/**
+ * Returns number of pages in the database file
+ */
+int DiskManager::GetNumPages() {
+  struct stat stat_buf;
+  return fstat(db_fd_, &stat_buf) == 0 ? static_cast<int>(stat_buf.st_size / PAGE_SIZE) : 0;
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.cpp
+//
+// Identification: src/storage/page/free_space_map_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/free_space_map_page.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+void FreeSpaceMapPage::Init(page_id_t table_id) {
+  table_id_ = table_id;
+  next_page_id_ = INVALID_PAGE_ID;
+  num_entries_ = 0;
+  memset(tree_, 0, sizeof(tree_));
+}
+
+uint32_t FreeSpaceMapPage::Append(page_id_t table_page_id, uint32_t free_space) {
+  uint32_t index = num_entries_++;
+  page_ids_[index] = table_page_id;
+  SetFreeSpace(index, free_space);
+  return index;
+}
+
+void FreeSpaceMapPage::SetFreeSpace(uint32_t index, uint32_t free_space) {
+  uint32_t node = CAPACITY + index;
+  tree_[node] = ToCategory(free_space);
+  for (node /= 2; node > 0; node /= 2) {
+    tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+  }
+}
+
+uint32_t FreeSpaceMapPage::Find(uint32_t size) const {
+  const uint32_t needed = NeededCategory(size);
+  if (tree_[1] < needed) {
+    return num_entries_;
+  }
+  // Descend to the leftmost leaf that qualifies.
+  uint32_t node = 1;
+  while (node < CAPACITY) {
+    node = tree_[2 * node] >= needed ? 2 * node : 2 * node + 1;
+  }
+  return node - CAPACITY;
+}
+
+}  // namespace bustub
@@ -12,6 +12,12 @@
 
 #include "storage/page/hash_table_block_page.h"
 
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "storage/index/generic_key.h"
 
 namespace bustub {
@@ -40,6 +46,28 @@ inline static void UNSET_N_TH_BIT(std::atomic_char *char_arr, slot_offset_t buck
   const auto bit_offset = bucket_ind % 8;
   char_arr[arr_index] &= ~N_TH_BIT_MASK[bit_offset];
 }
+
+// Loads the 64 bits of a bitmap that start at a byte, the bit of the lowest index is the most significant one. The
+// bits past the end of the bitmap are 0.
+inline static uint64_t LOAD_WORD(const std::atomic_char *char_arr, size_t arr_size, size_t arr_index) {
+  static_assert(sizeof(std::atomic_char) == 1, "A bitmap is an array of bytes.");
+  const char *bytes = reinterpret_cast<const char *>(char_arr) + arr_index;
+  uint64_t word = 0;
+  if (arr_index + sizeof(word) <= arr_size) {
+    // A load of a constant size is a single instruction.
+    memcpy(&word, bytes, sizeof(word));
+  } else {
+    memcpy(&word, bytes, arr_size - arr_index);
+  }
+  return __builtin_bswap64(word);
+}
+// Reverses the order of the lower 16 bits.
+inline static uint32_t REVERSE_16_BITS(uint32_t bits) {
+  bits = ((bits >> 1) & 0x5555) | ((bits & 0x5555) << 1);
+  bits = ((bits >> 2) & 0x3333) | ((bits & 0x3333) << 2);
+  bits = ((bits >> 4) & 0x0F0F) | ((bits & 0x0F0F) << 4);
+  return ((bits >> 8) & 0x00FF) | ((bits & 0x00FF) << 8);
+}
 /************ Helpers End ************/
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -82,6 +110,89 @@ bool HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
   return GET_N_TH_BIT(readable_, bucket_ind);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Combine>
+slot_offset_t HASH_TABLE_BLOCK_TYPE::FindIndex(slot_offset_t begin, slot_offset_t end, Combine &&combine) const {
+  constexpr size_t arr_size = sizeof(occupied_);
+  while (begin < end) {
+    const size_t arr_index = begin / 8;
+    uint64_t word = combine(LOAD_WORD(occupied_, arr_size, arr_index), LOAD_WORD(readable_, arr_size, arr_index));
+    // Drop the indexes before begin.
+    word &= ~0ULL >> (begin % 8);
+    if (word != 0) {
+      return std::min<slot_offset_t>(arr_index * 8 + __builtin_clzll(word), end);
+    }
+    begin = arr_index * 8 + 64;
+  }
+  return end;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_BLOCK_TYPE::ReadableBits(slot_offset_t begin, slot_offset_t end) const {
+  if (begin >= end) {
+    return 0;
+  }
+  constexpr size_t arr_size = sizeof(readable_);
+  const size_t arr_index = begin / 8;
+  const size_t bit_offset = begin % 8;
+  uint64_t word = LOAD_WORD(readable_, arr_size, arr_index) << bit_offset;
+  if (bit_offset != 0 && arr_index + 8 < arr_size) {
+    word |= static_cast<uint8_t>(readable_[arr_index + 8]) >> (8 - bit_offset);
+  }
+  if (end - begin < 64) {
+    word &= ~(~0ULL >> (end - begin));
+  }
+  return word;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+slot_offset_t HASH_TABLE_BLOCK_TYPE::NextFree(slot_offset_t begin, slot_offset_t end) const {
+  return FindIndex(begin, end, [](uint64_t /*occupied*/, uint64_t readable) { return ~readable; });
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+slot_offset_t HASH_TABLE_BLOCK_TYPE::NextUnoccupied(slot_offset_t begin, slot_offset_t end) const {
+  return FindIndex(begin, end, [](uint64_t occupied, uint64_t /*readable*/) { return ~occupied; });
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+slot_offset_t HASH_TABLE_BLOCK_TYPE::NextTombstone(slot_offset_t begin, slot_offset_t end) const {
+  return FindIndex(begin, end, [](uint64_t occupied, uint64_t readable) { return occupied & ~readable; });
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BLOCK_TYPE::SetFingerprint(slot_offset_t bucket_ind, uint8_t fingerprint) {
+  reinterpret_cast<char *>(array_ + FINGERPRINT_ARRAY_SIZE)[bucket_ind] = static_cast<char>(fingerprint);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_BLOCK_TYPE::FingerprintBits(slot_offset_t begin, slot_offset_t end, uint8_t fingerprint) const {
+  if (begin >= end) {
+    return 0;
+  }
+  const char *fingerprints = Fingerprints() + begin;
+  const slot_offset_t count = std::min<slot_offset_t>(64, end - begin);
+  uint64_t bits = 0;
+  for (slot_offset_t group = 0; group < count; group += 16) {
+    // The bit of the first of the 16 fingerprints is the least significant one of the mask.
+#ifdef __SSE2__
+    const __m128i group_fingerprints = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints + group));
+    const auto mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(group_fingerprints, _mm_set1_epi8(static_cast<char>(fingerprint)))));
+#else
+    uint32_t mask = 0;
+    for (slot_offset_t i = 0; i < 16; i++) {
+      mask |= (static_cast<uint8_t>(fingerprints[group + i]) == fingerprint ? 1U : 0U) << i;
+    }
+#endif
+    bits |= static_cast<uint64_t>(REVERSE_16_BITS(mask)) << (48 - group);
+  }
+  if (count < 64) {
+    bits &= ~(~0ULL >> count);
+  }
+  return bits;
+}
+
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
 template class HashTableBlockPage<int, int, IntComparator>;
 template class HashTableBlockPage<GenericKey<4>, RID, GenericComparator<4>>;
@@ -12,6 +12,8 @@
 
 #include "storage/page/hash_table_header_page.h"
 
+#include <cstring>
+
 namespace bustub {
 
 page_id_t HashTableHeaderPage::GetBlockPageId(size_t index) { return block_page_ids_[index]; }
@@ -32,4 +34,25 @@ void HashTableHeaderPage::SetSize(size_t size) { size_ = size; }
 
 size_t HashTableHeaderPage::GetSize() const { return size_; }
 
+void HashTableHeaderPage::SetOldSize(size_t old_size) { old_size_ = old_size; }
+
+size_t HashTableHeaderPage::GetOldSize() const { return old_size_; }
+
+void HashTableHeaderPage::SetMovedBuckets(size_t moved_buckets) { moved_buckets_ = moved_buckets; }
+
+size_t HashTableHeaderPage::GetMovedBuckets() const { return moved_buckets_; }
+
+void HashTableHeaderPage::SetNumPairs(size_t num_pairs) { num_pairs_ = num_pairs; }
+
+size_t HashTableHeaderPage::GetNumPairs() const { return num_pairs_; }
+
+void HashTableHeaderPage::SetNumTombstones(size_t num_tombstones) { num_tombstones_ = num_tombstones; }
+
+size_t HashTableHeaderPage::GetNumTombstones() const { return num_tombstones_; }
+
+void HashTableHeaderPage::RemoveBlockPageIds(size_t count) {
+  memmove(block_page_ids_, block_page_ids_ + count, (next_ind_ - count) * sizeof(page_id_t));
+  next_ind_ -= count;
+}
+
 }  // namespace bustub
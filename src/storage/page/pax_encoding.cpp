@@ -0,0 +1,400 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_encoding.cpp
+//
+// Identification: src/storage/page/pax_encoding.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_encoding.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace bustub {
+
+namespace {
+// bytes of the 64 bit words holding count codes of width bits
+uint32_t CodeBytes(uint32_t count, uint32_t width) {
+  return static_cast<uint32_t>((uint64_t{count} * width + 63) / 64 * 8);
+}
+
+uint32_t Align8(uint32_t size) { return (size + 7) / 8 * 8; }
+
+void Pack(char *words, uint32_t width, uint32_t index, uint64_t code) {
+  if (width == 0) {
+    return;
+  }
+  const uint64_t bit = uint64_t{index} * width;
+  char *word_ptr = words + bit / 64 * 8;
+  const uint32_t shift = bit % 64;
+  uint64_t word;
+  memcpy(&word, word_ptr, sizeof(word));
+  word |= code << shift;
+  memcpy(word_ptr, &word, sizeof(word));
+  if (shift + width > 64) {
+    memcpy(&word, word_ptr + 8, sizeof(word));
+    word |= code >> (64 - shift);
+    memcpy(word_ptr + 8, &word, sizeof(word));
+  }
+}
+
+uint64_t Unpack(const char *words, uint32_t width, uint32_t index) {
+  if (width == 0) {
+    return 0;
+  }
+  const uint64_t bit = uint64_t{index} * width;
+  const char *word_ptr = words + bit / 64 * 8;
+  const uint32_t shift = bit % 64;
+  uint64_t word;
+  memcpy(&word, word_ptr, sizeof(word));
+  uint64_t code = word >> shift;
+  if (shift + width > 64) {
+    memcpy(&word, word_ptr + 8, sizeof(word));
+    code |= word << (64 - shift);
+  }
+  return width == 64 ? code : code & ((uint64_t{1} << width) - 1);
+}
+
+uint32_t LoadUint32(const char *src) {
+  uint32_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+}
+
+int64_t LoadInt64(const char *src) {
+  int64_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+}
+
+// the value is stored little endian, so its first length bytes are the value of the column
+void StoreInteger(char *dest, int64_t value, uint32_t length) { memcpy(dest, &value, length); }
+
+// The headers of the encoded minipages, see PaxEncoding.
+struct FrameOfReference {
+  explicit FrameOfReference(const char *minipage)
+      : base_(LoadInt64(minipage)), width_(LoadUint32(minipage + 8)), codes_(minipage + 16) {}
+  int64_t Decode(uint64_t code) const { return static_cast<int64_t>(static_cast<uint64_t>(base_) + code); }
+  int64_t base_;
+  uint32_t width_;
+  const char *codes_;
+};
+
+struct Dictionary {
+  explicit Dictionary(const char *minipage)
+      : size_(LoadUint32(minipage)),
+        width_(LoadUint32(minipage + 4)),
+        values_(minipage + 8),
+        codes_(minipage + 8 + 8 * size_) {}
+  int64_t Decode(uint64_t code) const { return LoadInt64(values_ + 8 * code); }
+  uint32_t size_;
+  uint32_t width_;
+  const char *values_;
+  const char *codes_;
+};
+
+struct Rle {
+  explicit Rle(const char *minipage)
+      : run_count_(LoadUint32(minipage)), values_(minipage + 8), ends_(minipage + 8 + 8 * run_count_) {}
+  int64_t GetValue(uint32_t run) const { return LoadInt64(values_ + 8 * run); }
+  uint32_t GetEnd(uint32_t run) const { return LoadUint32(ends_ + 4 * run); }
+  uint32_t run_count_;
+  const char *values_;
+  const char *ends_;
+};
+
+// Copies fixed-size values, the common lengths compile to a plain load and store.
+template <uint32_t Length>
+void GatherPlain(const char *minipage, const std::vector<uint32_t> &slots, char *rows, uint32_t row_length) {
+  for (uint32_t slot_num : slots) {
+    memcpy(rows, minipage + slot_num * Length, Length);
+    rows += row_length;
+  }
+}
+
+// Keeps the slots for which keep(slot_num) is true.
+template <typename Keep>
+void RetainSlots(std::vector<uint32_t> *slots, Keep keep) {
+  size_t kept = 0;
+  for (uint32_t slot_num : *slots) {
+    if (keep(slot_num)) {
+      (*slots)[kept++] = slot_num;
+    }
+  }
+  slots->resize(kept);
+}
+}  // namespace
+
+void PaxColumnEncoder::Add(const char *src) {
+  if (!is_integer_) {
+    count_++;
+    return;
+  }
+  const int64_t value = PaxMinipage::LoadInteger(src, length_);
+  if (count_ == 0) {
+    min_ = value;
+    max_ = value;
+    run_count_ = 1;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    run_count_ += value != last_ ? 1 : 0;
+  }
+  last_ = value;
+  if (!dictionary_full_) {
+    distinct_.insert(value);
+    if (distinct_.size() > MAX_DICTIONARY_SIZE) {
+      dictionary_full_ = true;
+      distinct_.clear();
+    }
+  }
+  count_++;
+}
+
+uint32_t PaxColumnEncoder::GetEncodedSize(PaxEncoding encoding) const {
+  switch (encoding) {
+    case PaxEncoding::PLAIN:
+      return Align8(count_ * length_);
+    case PaxEncoding::FRAME_OF_REFERENCE:
+      return 16 + CodeBytes(count_, CodeWidth(static_cast<uint64_t>(max_) - static_cast<uint64_t>(min_)));
+    case PaxEncoding::DICTIONARY: {
+      if (dictionary_full_) {
+        return std::numeric_limits<uint32_t>::max();
+      }
+      const auto size = static_cast<uint32_t>(distinct_.size());
+      return 8 + 8 * size + CodeBytes(count_, CodeWidth(size == 0 ? 0 : size - 1));
+    }
+    case PaxEncoding::RLE:
+      return 8 + Align8(12 * run_count_);
+  }
+  return std::numeric_limits<uint32_t>::max();
+}
+
+PaxEncoding PaxColumnEncoder::GetEncoding() const {
+  if (!is_integer_ || count_ == 0) {
+    return PaxEncoding::PLAIN;
+  }
+  // On a tie the encoding that is cheaper to read wins.
+  PaxEncoding best = PaxEncoding::PLAIN;
+  for (auto encoding : {PaxEncoding::FRAME_OF_REFERENCE, PaxEncoding::DICTIONARY, PaxEncoding::RLE}) {
+    if (GetEncodedSize(encoding) < GetEncodedSize(best)) {
+      best = encoding;
+    }
+  }
+  return best;
+}
+
+void PaxColumnEncoder::Write(const char *values, size_t stride, char *dest) const {
+  const PaxEncoding encoding = GetEncoding();
+  memset(dest, 0, GetEncodedSize(encoding));
+  switch (encoding) {
+    case PaxEncoding::PLAIN:
+      for (uint32_t i = 0; i < count_; i++) {
+        memcpy(dest + i * length_, values + i * stride, length_);
+      }
+      break;
+    case PaxEncoding::FRAME_OF_REFERENCE: {
+      const uint32_t width = CodeWidth(static_cast<uint64_t>(max_) - static_cast<uint64_t>(min_));
+      memcpy(dest, &min_, sizeof(min_));
+      memcpy(dest + 8, &width, sizeof(width));
+      for (uint32_t i = 0; i < count_; i++) {
+        const int64_t value = PaxMinipage::LoadInteger(values + i * stride, length_);
+        Pack(dest + 16, width, i, static_cast<uint64_t>(value) - static_cast<uint64_t>(min_));
+      }
+      break;
+    }
+    case PaxEncoding::DICTIONARY: {
+      const std::vector<int64_t> dictionary(distinct_.begin(), distinct_.end());
+      const auto size = static_cast<uint32_t>(dictionary.size());
+      const uint32_t width = CodeWidth(size - 1);
+      memcpy(dest, &size, sizeof(size));
+      memcpy(dest + 4, &width, sizeof(width));
+      memcpy(dest + 8, dictionary.data(), 8 * size);
+      for (uint32_t i = 0; i < count_; i++) {
+        const int64_t value = PaxMinipage::LoadInteger(values + i * stride, length_);
+        const auto code = std::lower_bound(dictionary.begin(), dictionary.end(), value) - dictionary.begin();
+        Pack(dest + 8 + 8 * size, width, i, code);
+      }
+      break;
+    }
+    case PaxEncoding::RLE: {
+      memcpy(dest, &run_count_, sizeof(run_count_));
+      char *run_values = dest + 8;
+      char *run_ends = dest + 8 + 8 * run_count_;
+      uint32_t run = 0;
+      int64_t run_value = PaxMinipage::LoadInteger(values, length_);
+      for (uint32_t i = 1; i <= count_; i++) {
+        const int64_t value = i < count_ ? PaxMinipage::LoadInteger(values + i * stride, length_) : run_value;
+        if (i == count_ || value != run_value) {
+          memcpy(run_values + 8 * run, &run_value, sizeof(run_value));
+          memcpy(run_ends + 4 * run, &i, sizeof(i));
+          run++;
+          run_value = value;
+        }
+      }
+      break;
+    }
+  }
+}
+
+void PaxMinipage::GetValue(PaxEncoding encoding, const char *minipage, uint32_t length, uint32_t slot_num,
+                           char *dest) {
+  switch (encoding) {
+    case PaxEncoding::PLAIN:
+      memcpy(dest, minipage + slot_num * length, length);
+      break;
+    case PaxEncoding::FRAME_OF_REFERENCE: {
+      FrameOfReference frame(minipage);
+      StoreInteger(dest, frame.Decode(Unpack(frame.codes_, frame.width_, slot_num)), length);
+      break;
+    }
+    case PaxEncoding::DICTIONARY: {
+      Dictionary dictionary(minipage);
+      StoreInteger(dest, dictionary.Decode(Unpack(dictionary.codes_, dictionary.width_, slot_num)), length);
+      break;
+    }
+    case PaxEncoding::RLE: {
+      // The first run that ends after the slot.
+      Rle rle(minipage);
+      uint32_t low = 0;
+      uint32_t high = rle.run_count_ - 1;
+      while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (rle.GetEnd(mid) <= slot_num) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      StoreInteger(dest, rle.GetValue(low), length);
+      break;
+    }
+  }
+}
+
+void PaxMinipage::Gather(PaxEncoding encoding, const char *minipage, uint32_t length,
+                         const std::vector<uint32_t> &slots, char *rows, uint32_t row_length) {
+  switch (encoding) {
+    case PaxEncoding::PLAIN:
+      switch (length) {
+        case 1:
+          return GatherPlain<1>(minipage, slots, rows, row_length);
+        case 2:
+          return GatherPlain<2>(minipage, slots, rows, row_length);
+        case 4:
+          return GatherPlain<4>(minipage, slots, rows, row_length);
+        case 8:
+          return GatherPlain<8>(minipage, slots, rows, row_length);
+        default:
+          for (uint32_t slot_num : slots) {
+            memcpy(rows, minipage + slot_num * length, length);
+            rows += row_length;
+          }
+          return;
+      }
+    case PaxEncoding::FRAME_OF_REFERENCE: {
+      FrameOfReference frame(minipage);
+      for (uint32_t slot_num : slots) {
+        StoreInteger(rows, frame.Decode(Unpack(frame.codes_, frame.width_, slot_num)), length);
+        rows += row_length;
+      }
+      return;
+    }
+    case PaxEncoding::DICTIONARY: {
+      Dictionary dictionary(minipage);
+      for (uint32_t slot_num : slots) {
+        StoreInteger(rows, dictionary.Decode(Unpack(dictionary.codes_, dictionary.width_, slot_num)), length);
+        rows += row_length;
+      }
+      return;
+    }
+    case PaxEncoding::RLE: {
+      // The slots are in order, so the runs are walked once.
+      Rle rle(minipage);
+      uint32_t run = 0;
+      for (uint32_t slot_num : slots) {
+        while (rle.GetEnd(run) <= slot_num) {
+          run++;
+        }
+        StoreInteger(rows, rle.GetValue(run), length);
+        rows += row_length;
+      }
+      return;
+    }
+  }
+}
+
+void PaxMinipage::Filter(PaxEncoding encoding, const char *minipage, uint32_t length, const PaxPredicate &predicate,
+                         std::vector<uint32_t> *slots) {
+  if (slots->empty()) {
+    return;
+  }
+  // The null value of an integer column is the smallest value of its type.
+  const int64_t null_value = length == 8 ? std::numeric_limits<int64_t>::min() : -(int64_t{1} << (8 * length - 1));
+  auto matches = [&](int64_t value) {
+    return value != null_value && ((predicate.low_ <= value && value <= predicate.high_) != predicate.negate_);
+  };
+
+  switch (encoding) {
+    case PaxEncoding::PLAIN:
+      RetainSlots(slots, [&](uint32_t slot_num) { return matches(LoadInteger(minipage + slot_num * length, length)); });
+      return;
+    case PaxEncoding::FRAME_OF_REFERENCE: {
+      // Turn the range of values into a range of codes, and compare the codes.
+      FrameOfReference frame(minipage);
+      const auto base = static_cast<uint64_t>(frame.base_);
+      const bool empty = predicate.high_ < frame.base_ || predicate.low_ > predicate.high_;
+      const uint64_t low_code = predicate.low_ <= frame.base_ ? 0 : static_cast<uint64_t>(predicate.low_) - base;
+      const uint64_t high_code = empty ? 0 : static_cast<uint64_t>(predicate.high_) - base;
+      // Only the smallest value, code 0, can be null.
+      const bool code_0_is_null = frame.base_ == null_value;
+      RetainSlots(slots, [&](uint32_t slot_num) {
+        const uint64_t code = Unpack(frame.codes_, frame.width_, slot_num);
+        const bool in_range = !empty && low_code <= code && code <= high_code;
+        return !(code_0_is_null && code == 0) && in_range != predicate.negate_;
+      });
+      return;
+    }
+    case PaxEncoding::DICTIONARY: {
+      // Evaluate the predicate once per distinct value.
+      Dictionary dictionary(minipage);
+      std::vector<uint8_t> code_matches(dictionary.size_);
+      bool any = false;
+      for (uint32_t code = 0; code < dictionary.size_; code++) {
+        code_matches[code] = matches(dictionary.Decode(code)) ? 1 : 0;
+        any = any || code_matches[code] != 0;
+      }
+      if (!any) {
+        slots->clear();
+        return;
+      }
+      RetainSlots(slots, [&](uint32_t slot_num) {
+        return code_matches[Unpack(dictionary.codes_, dictionary.width_, slot_num)] != 0;
+      });
+      return;
+    }
+    case PaxEncoding::RLE: {
+      // Evaluate the predicate once per run.
+      Rle rle(minipage);
+      uint32_t run = 0;
+      bool run_matches = matches(rle.GetValue(0));
+      RetainSlots(slots, [&](uint32_t slot_num) {
+        if (rle.GetEnd(run) <= slot_num) {
+          do {
+            run++;
+          } while (rle.GetEnd(run) <= slot_num);
+          run_matches = matches(rle.GetValue(run));
+        }
+        return run_matches;
+      });
+      return;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.cpp
+//
+// Identification: src/storage/page/pax_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_page.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+// The minipages start after the bitmap, at an 8 byte boundary.
+uint32_t MinipagesBegin(uint32_t capacity) {
+  return (PaxPage::SIZE_PAX_PAGE_HEADER + (capacity + 7) / 8 + 7) / 8 * 8;
+}
+}  // namespace
+
+PaxLayout::PaxLayout(const Schema &schema) : tuple_length_(schema.GetLength()) {
+  BUSTUB_ASSERT(schema.IsInlined(), "A PAX page holds fixed-width columns only.");
+  for (const auto &column : schema.GetColumns()) {
+    lengths_.emplace_back(column.GetFixedLength());
+    tuple_offsets_.emplace_back(column.GetOffset());
+    const TypeId type = column.GetType();
+    is_integer_.emplace_back(type == TypeId::BOOLEAN || type == TypeId::TINYINT || type == TypeId::SMALLINT ||
+                             type == TypeId::INTEGER || type == TypeId::BIGINT);
+  }
+  // Every tuple takes its length and a bit.
+  capacity_ = (PAGE_SIZE - PaxPage::SIZE_PAX_PAGE_HEADER) * 8 / (8 * tuple_length_ + 1);
+  while (MinipagesBegin(capacity_) + capacity_ * tuple_length_ > PAGE_SIZE) {
+    capacity_--;
+  }
+  uint32_t offset = MinipagesBegin(capacity_);
+  for (uint32_t length : lengths_) {
+    minipage_offsets_.emplace_back(offset);
+    offset += capacity_ * length;
+  }
+}
+
+std::vector<PaxColumnEncoder> PaxLayout::CreateEncoders() const {
+  std::vector<PaxColumnEncoder> encoders;
+  encoders.reserve(lengths_.size());
+  for (uint32_t i = 0; i < lengths_.size(); i++) {
+    encoders.emplace_back(lengths_[i], is_integer_[i]);
+  }
+  return encoders;
+}
+
+void PaxPage::Init(const PaxLayout &layout, page_id_t page_id, page_id_t prev_page_id) {
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  SetPrevPageId(prev_page_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetTupleCount(0);
+  SetLiveCount(0);
+  SetFlags(0);
+  memset(GetData() + SIZE_PAX_PAGE_HEADER, 0, (layout.GetCapacity() + 7) / 8);
+}
+
+void PaxPage::InitSealed(const PaxLayout &layout, page_id_t page_id, page_id_t prev_page_id, const char *rows,
+                         uint32_t tuple_count, const std::vector<PaxColumnEncoder> &encoders) {
+  BUSTUB_ASSERT(tuple_count <= MAX_SEALED_TUPLES && GetSealedSize(layout, encoders, tuple_count) <= PAGE_SIZE,
+                "The tuples do not fit into a sealed page.");
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  SetPrevPageId(prev_page_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetTupleCount(tuple_count);
+  SetLiveCount(tuple_count);
+  SetFlags(FLAG_SEALED);
+  // All the tuples are live.
+  char *bitmap = GetData() + SIZE_PAX_PAGE_HEADER;
+  memset(bitmap, 0xFF, tuple_count / 8);
+  if (tuple_count % 8 != 0) {
+    bitmap[tuple_count / 8] = static_cast<char>((1U << (tuple_count % 8)) - 1);
+  }
+
+  std::vector<std::pair<const char *, size_t>> columns;
+  for (uint32_t i = 0; i < layout.GetColumnCount(); i++) {
+    columns.emplace_back(rows + layout.GetTupleOffset(i), layout.GetTupleLength());
+  }
+  WriteSealed(layout, encoders, columns, GetData());
+}
+
+bool PaxPage::Seal(const PaxLayout &layout) {
+  const uint32_t tuple_count = GetTupleCount();
+  if (IsSealed() || tuple_count == 0) {
+    return false;
+  }
+  std::vector<PaxColumnEncoder> encoders = layout.CreateEncoders();
+  std::vector<std::pair<const char *, size_t>> columns;
+  bool encoded = false;
+  for (uint32_t i = 0; i < layout.GetColumnCount(); i++) {
+    const uint32_t length = layout.GetColumnLength(i);
+    const char *minipage = GetData() + layout.GetMinipageOffset(i);
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      encoders[i].Add(minipage + slot_num * length);
+    }
+    columns.emplace_back(minipage, length);
+    encoded = encoded || encoders[i].GetEncoding() != PaxEncoding::PLAIN;
+  }
+  const uint32_t sealed_size = GetSealedSize(layout, encoders, tuple_count);
+  if (!encoded || sealed_size > PAGE_SIZE) {
+    return false;
+  }
+
+  // The new minipages overlap the old ones, so they are written to a copy first.
+  std::vector<char> sealed(PAGE_SIZE);
+  WriteSealed(layout, encoders, columns, sealed.data());
+  const uint32_t directory_offset = GetDirectoryOffset(tuple_count);
+  memcpy(GetData() + directory_offset, sealed.data() + directory_offset, sealed_size - directory_offset);
+  memset(GetData() + sealed_size, 0, PAGE_SIZE - sealed_size);
+  SetFlags(FLAG_SEALED);
+  return true;
+}
+
+uint32_t PaxPage::GetSealedSize(const PaxLayout &layout, const std::vector<PaxColumnEncoder> &encoders,
+                                uint32_t tuple_count) {
+  uint32_t size = GetDirectoryOffset(tuple_count) + layout.GetColumnCount() * SIZE_DIRECTORY_ENTRY;
+  for (const auto &encoder : encoders) {
+    size += encoder.GetEncodedSize();
+  }
+  return size;
+}
+
+void PaxPage::WriteSealed(const PaxLayout &layout, const std::vector<PaxColumnEncoder> &encoders,
+                          const std::vector<std::pair<const char *, size_t>> &columns, char *data) {
+  const uint32_t directory_offset = GetDirectoryOffset(GetTupleCount());
+  uint32_t offset = directory_offset + layout.GetColumnCount() * SIZE_DIRECTORY_ENTRY;
+  for (uint32_t i = 0; i < layout.GetColumnCount(); i++) {
+    char *entry = data + directory_offset + i * SIZE_DIRECTORY_ENTRY;
+    memset(entry, 0, SIZE_DIRECTORY_ENTRY);
+    entry[0] = static_cast<char>(encoders[i].GetEncoding());
+    memcpy(entry + 4, &offset, sizeof(offset));
+    encoders[i].Write(columns[i].first, columns[i].second, data + offset);
+    offset += encoders[i].GetEncodedSize();
+  }
+}
+
+const char *PaxPage::GetMinipage(const PaxLayout &layout, uint32_t column_idx, PaxEncoding *encoding) {
+  if (!IsSealed()) {
+    *encoding = PaxEncoding::PLAIN;
+    return GetData() + layout.GetMinipageOffset(column_idx);
+  }
+  const char *entry = GetData() + GetDirectoryOffset(GetTupleCount()) + column_idx * SIZE_DIRECTORY_ENTRY;
+  *encoding = static_cast<PaxEncoding>(entry[0]);
+  uint32_t offset;
+  memcpy(&offset, entry + 4, sizeof(offset));
+  return GetData() + offset;
+}
+
+bool PaxPage::InsertTuple(const PaxLayout &layout, const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.GetLength() == layout.GetTupleLength(), "The tuple does not have the schema of the table.");
+  if (IsSealed() || GetLiveCount() == layout.GetCapacity()) {
+    return false;
+  }
+  uint32_t slot_num = GetTupleCount();
+  if (slot_num < layout.GetCapacity()) {
+    SetTupleCount(slot_num + 1);
+  } else {
+    // Every slot has been used, take the first one that was deleted.
+    for (slot_num = 0; IsLive(slot_num); slot_num++) {
+    }
+  }
+
+  // Scatter the values over the minipages.
+  const char *data = tuple.GetData();
+  for (uint32_t i = 0; i < layout.GetColumnCount(); i++) {
+    const uint32_t length = layout.GetColumnLength(i);
+    memcpy(GetData() + layout.GetMinipageOffset(i) + slot_num * length, data + layout.GetTupleOffset(i), length);
+  }
+  SetLive(slot_num, true);
+  SetLiveCount(GetLiveCount() + 1);
+  rid->Set(GetTablePageId(), slot_num);
+  return true;
+}
+
+bool PaxPage::DeleteTuple(const RID &rid) {
+  const uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || !IsLive(slot_num)) {
+    return false;
+  }
+  SetLive(slot_num, false);
+  SetLiveCount(GetLiveCount() - 1);
+  return true;
+}
+
+bool PaxPage::GetTuple(const PaxLayout &layout, const RID &rid, Tuple *tuple) {
+  const uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || !IsLive(slot_num)) {
+    return false;
+  }
+  // Gather the values from the minipages, decoding them.
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->data_ = new char[layout.GetTupleLength()];
+  tuple->allocated_ = true;
+  tuple->size_ = layout.GetTupleLength();
+  tuple->overflow_page_id_ = INVALID_PAGE_ID;
+  tuple->rid_ = rid;
+  for (uint32_t i = 0; i < layout.GetColumnCount(); i++) {
+    PaxEncoding encoding;
+    const char *minipage = GetMinipage(layout, i, &encoding);
+    PaxMinipage::GetValue(encoding, minipage, layout.GetColumnLength(i), slot_num,
+                          tuple->data_ + layout.GetTupleOffset(i));
+  }
+  return true;
+}
+
+void PaxPage::ReadColumn(const PaxLayout &layout, uint32_t column_idx, const std::vector<uint32_t> &slots, char *rows,
+                         uint32_t row_length) {
+  PaxEncoding encoding;
+  const char *minipage = GetMinipage(layout, column_idx, &encoding);
+  PaxMinipage::Gather(encoding, minipage, layout.GetColumnLength(column_idx), slots, rows, row_length);
+}
+
+void PaxPage::Filter(const PaxLayout &layout, const PaxPredicate &predicate, std::vector<uint32_t> *slots) {
+  BUSTUB_ASSERT(layout.IsInteger(predicate.column_idx_), "Predicates are on integer columns only.");
+  PaxEncoding encoding;
+  const char *minipage = GetMinipage(layout, predicate.column_idx_, &encoding);
+  PaxMinipage::Filter(encoding, minipage, layout.GetColumnLength(predicate.column_idx_), predicate, slots);
+}
+
+}  // namespace bustub
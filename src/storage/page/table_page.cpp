@@ -32,38 +32,43 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(page_size);
   SetTupleCount(0);
+  SetFreeSpaceMapPageId(INVALID_PAGE_ID);
+  SetFreeSlot(INVALID_SLOT);
+  SetDeadSpace(0);
 }
 
 bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
                             LogManager *log_manager) {
   BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  const uint32_t tuple_size = GetStoredSize(tuple);
+  // A reused slot is already there, only a new slot takes space.
+  const uint32_t needed = tuple_size + (GetFreeSlot() == INVALID_SLOT ? SIZE_TUPLE : 0);
   // If there is not enough space, then return false.
-  if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
+  if (GetFreeSpaceRemaining() < needed) {
     return false;
   }
 
-  // Try to find a free slot to reuse.
-  uint32_t i;
-  for (i = 0; i < GetTupleCount(); i++) {
-    // If the slot is empty, i.e. its tuple has size 0,
-    if (GetTupleSize(i) == 0) {
-      // Then we break out of the loop at index i.
-      break;
-    }
+  // Make the dead space usable if the free space does not do.
+  if (GetContiguousFreeSpace() < needed) {
+    Compact();
   }
 
-  // If there was no free slot left, and we cannot claim it from the free space, then we give up.
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
-    return false;
+  // Reuse the first free slot if there is one, otherwise claim a new slot.
+  uint32_t i = GetFreeSlot();
+  if (i != INVALID_SLOT) {
+    SetFreeSlot(GetTupleOffsetAtSlot(i));
+  } else {
+    i = GetTupleCount();
   }
 
-  // Otherwise we claim available free space..
-  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
-  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  // Claim available free space.
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple_size);
+  WriteTuple(GetFreeSpacePointer(), tuple);
 
   // Set the tuple.
   SetTupleOffsetAtSlot(i, GetFreeSpacePointer());
-  SetTupleSize(i, tuple.size_);
+  SetTupleSize(i, tuple_size);
+  SetOverflowFlag(i, tuple.overflow_page_id_ != INVALID_PAGE_ID);
 
   rid->Set(GetTablePageId(), i);
   if (i == GetTupleCount()) {
@@ -84,6 +89,34 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   return true;
 }
 
+bool TablePage::AppendTuple(const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  const uint32_t tuple_size = GetStoredSize(tuple);
+  if (GetFreeSpaceRemaining() < tuple_size + SIZE_TUPLE) {
+    return false;
+  }
+  if (GetContiguousFreeSpace() < tuple_size + SIZE_TUPLE) {
+    Compact();
+  }
+  uint32_t slot_num = GetTupleCount();
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple_size);
+  WriteTuple(GetFreeSpacePointer(), tuple);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple_size);
+  SetOverflowFlag(slot_num, tuple.overflow_page_id_ != INVALID_PAGE_ID);
+  SetTupleCount(slot_num + 1);
+  rid->Set(GetTablePageId(), slot_num);
+  return true;
+}
+
+void TablePage::LogPageImage(Transaction *txn, LogManager *log_manager) {
+  LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::PAGEIMAGE, GetTablePageId(),
+                       GetData());
+  lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+  SetLSN(lsn);
+  txn->SetPrevLSN(lsn);
+}
+
 bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
@@ -145,21 +178,21 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
     }
     return false;
   }
+  const uint32_t new_tuple_size = GetStoredSize(new_tuple);
   // If there is not enuogh space to update, we need to update via delete followed by an insert (not enough space).
-  if (GetFreeSpaceRemaining() + tuple_size < new_tuple.size_) {
+  if (GetFreeSpaceRemaining() + tuple_size < new_tuple_size) {
     return false;
   }
+  // The tuple grows into the free space, make the dead space part of it if needed.
+  if (GetContiguousFreeSpace() + tuple_size < new_tuple_size) {
+    Compact();
+  }
 
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  old_tuple->size_ = tuple_size;
-  if (old_tuple->allocated_) {
-    delete[] old_tuple->data_;
-  }
-  old_tuple->data_ = new char[old_tuple->size_];
-  memcpy(old_tuple->data_, GetData() + tuple_offset, old_tuple->size_);
+  ReadTuple(slot_num, old_tuple);
   old_tuple->rid_ = rid;
-  old_tuple->allocated_ = true;
+  old_tuple->Materialize();
 
   if (enable_logging) {
     // Acquire an exclusive lock, upgrading from shared if necessary.
@@ -180,17 +213,18 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   uint32_t free_space_pointer = GetFreeSpacePointer();
   BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
 
-  memmove(GetData() + free_space_pointer + tuple_size - new_tuple.size_, GetData() + free_space_pointer,
+  memmove(GetData() + free_space_pointer + tuple_size - new_tuple_size, GetData() + free_space_pointer,
           tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size - new_tuple.size_);
-  memcpy(GetData() + tuple_offset + tuple_size - new_tuple.size_, new_tuple.data_, new_tuple.size_);
-  SetTupleSize(slot_num, new_tuple.size_);
+  SetFreeSpacePointer(free_space_pointer + tuple_size - new_tuple_size);
+  WriteTuple(tuple_offset + tuple_size - new_tuple_size, new_tuple);
+  SetTupleSize(slot_num, new_tuple_size);
+  SetOverflowFlag(slot_num, new_tuple.overflow_page_id_ != INVALID_PAGE_ID);
 
   // Update all tuple offsets.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
     uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
     if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_tuple.size_);
+      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_tuple_size);
     }
   }
   return true;
@@ -202,6 +236,10 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
 
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t tuple_size = GetTupleSize(slot_num);
+  // The slot is empty already.
+  if (tuple_size == 0) {
+    return;
+  }
   // Check if this is a delete operation, i.e. commit a delete.
   if (IsDeleted(tuple_size)) {
     tuple_size = UnsetDeletedFlag(tuple_size);
@@ -225,22 +263,66 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
     txn->SetPrevLSN(lsn);
   }
 
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
-
-  memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size);
+  // Leave the bytes of the tuple for the next compaction, and put the slot on the free slot list.
+  SetDeadSpace(GetDeadSpace() + tuple_size);
   SetTupleSize(slot_num, 0);
-  SetTupleOffsetAtSlot(slot_num, 0);
+  SetOverflowFlag(slot_num, false);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSlot());
+  SetFreeSlot(slot_num);
+}
 
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
+void TablePage::Compact() {
+  if (GetDeadSpace() == 0) {
+    return;
+  }
+  // Pack the live tuples at the end of a scratch page, in slot order, then copy them back in one go.
+  char scratch[PAGE_SIZE];
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t size = UnsetDeletedFlag(GetTupleSize(i));
+    if (size == 0) {
+      continue;
     }
+    free_space_pointer -= size;
+    memcpy(scratch + free_space_pointer, GetData() + GetTupleOffsetAtSlot(i), size);
+    SetTupleOffsetAtSlot(i, free_space_pointer);
   }
+  memcpy(GetData() + free_space_pointer, scratch + free_space_pointer, PAGE_SIZE - free_space_pointer);
+  SetFreeSpacePointer(free_space_pointer);
+  SetDeadSpace(0);
+}
+
+uint32_t TablePage::Vacuum() {
+  uint32_t reclaimed = GetDeadSpace();
+  Compact();
+
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  if (tuple_count < GetTupleCount()) {
+    reclaimed += SIZE_TUPLE * (GetTupleCount() - tuple_count);
+    SetTupleCount(tuple_count);
+    // Some of the dropped slots were on the free slot list, build it again from the slots that are left.
+    uint32_t free_slot = INVALID_SLOT;
+    for (uint32_t i = tuple_count; i-- > 0;) {
+      if (GetTupleSize(i) == 0) {
+        SetTupleOffsetAtSlot(i, free_slot);
+        free_slot = i;
+      }
+    }
+    SetFreeSlot(free_slot);
+  }
+  return reclaimed;
+}
+
+bool TablePage::IsEmpty() {
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    if (GetTupleSize(i) != 0) {
+      return false;
+    }
+  }
+  return true;
 }
 
 void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
@@ -265,6 +347,16 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log
 }
 
 bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  if (!GetTupleView(rid, tuple, txn, lock_manager)) {
+    return false;
+  }
+  // Copy the tuple data into our result, the overflow pages may be freed once the page is unlatched.
+  tuple->Materialize();
+  tuple->LoadOverflow(tuple->size_);
+  return true;
+}
+
+bool TablePage::GetTupleView(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
   // Get the current slot number.
   uint32_t slot_num = rid.GetSlotNum();
   // If somehow we have more slots than tuples, abort the transaction.
@@ -291,17 +383,49 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
     }
   }
 
-  // At this point, we have at least a shared lock on the RID. Copy the tuple data into our result.
-  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  tuple->size_ = tuple_size;
+  // At this point, we have at least a shared lock on the RID. Point our result at the tuple data.
+  ReadTuple(slot_num, tuple);
+  tuple->rid_ = rid;
+  return true;
+}
+
+page_id_t TablePage::GetOverflowPageId(const RID &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || !HasOverflow(slot_num)) {
+    return INVALID_PAGE_ID;
+  }
+  uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+  return *reinterpret_cast<page_id_t *>(GetData() + GetTupleOffsetAtSlot(slot_num) + tuple_size -
+                                        SIZE_OVERFLOW_POINTER);
+}
+
+void TablePage::WriteTuple(uint32_t offset, const Tuple &tuple) {
+  if (tuple.overflow_page_id_ == INVALID_PAGE_ID) {
+    memcpy(GetData() + offset, tuple.data_, tuple.size_);
+    return;
+  }
+  // The loaded bytes, then where the rest is.
+  memcpy(GetData() + offset, tuple.data_, tuple.loaded_size_);
+  memcpy(GetData() + offset + tuple.loaded_size_, &tuple.overflow_page_id_, sizeof(page_id_t));
+  memcpy(GetData() + offset + tuple.loaded_size_ + sizeof(page_id_t), &tuple.size_, sizeof(uint32_t));
+}
+
+void TablePage::ReadTuple(uint32_t slot_num, Tuple *tuple) {
+  uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+  char *data = GetData() + GetTupleOffsetAtSlot(slot_num);
   if (tuple->allocated_) {
     delete[] tuple->data_;
   }
-  tuple->data_ = new char[tuple->size_];
-  memcpy(tuple->data_, GetData() + tuple_offset, tuple->size_);
-  tuple->rid_ = rid;
-  tuple->allocated_ = true;
-  return true;
+  tuple->data_ = data;
+  tuple->allocated_ = false;
+  if (!HasOverflow(slot_num)) {
+    tuple->size_ = tuple_size;
+    tuple->overflow_page_id_ = INVALID_PAGE_ID;
+    return;
+  }
+  tuple->loaded_size_ = tuple_size - SIZE_OVERFLOW_POINTER;
+  tuple->overflow_page_id_ = *reinterpret_cast<page_id_t *>(data + tuple->loaded_size_);
+  tuple->size_ = *reinterpret_cast<uint32_t *>(data + tuple->loaded_size_ + sizeof(page_id_t));
 }
 
 bool TablePage::GetFirstTupleRid(RID *first_rid) {
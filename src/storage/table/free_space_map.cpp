@@ -0,0 +1,237 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include "common/logger.h"
+#include "storage/page/table_page.h"
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t table_id)
+    : buffer_pool_manager_(buffer_pool_manager), table_id_(table_id) {}
+
+void FreeSpaceMap::Load() {
+  if (loaded_) {
+    return;
+  }
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(table_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't fetch the first page of the table.");
+  first_page->RLatch();
+  page_id_t map_page_id = first_page->GetFreeSpaceMapPageId();
+  first_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(table_id_, false);
+
+  // Read the map.
+  while (map_page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(map_page_id);
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the free space map.");
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    page->RLatch();
+    if (map_page->GetTableId() != table_id_) {
+      // Not ours: the map of the table was never written. Start a new one, the table pages are picked up below.
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(map_page_id, false);
+      map_page_ids_.clear();
+      max_categories_.clear();
+      locations_.clear();
+      last_page_id_ = INVALID_PAGE_ID;
+      break;
+    }
+    map_page_ids_.emplace_back(map_page_id);
+    max_categories_.emplace_back(map_page->GetMaxCategory());
+    for (uint32_t i = 0; i < map_page->GetNumEntries(); i++) {
+      if (map_page->GetTablePageId(i) == INVALID_PAGE_ID) {
+        // The table page was removed.
+        continue;
+      }
+      last_page_id_ = map_page->GetTablePageId(i);
+      locations_[last_page_id_] = {map_page_ids_.size() - 1, i};
+    }
+    page_id_t next_page_id = map_page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    map_page_id = next_page_id;
+  }
+  loaded_ = true;
+
+  // Pick up the table pages after the last one the map knows about, or all of them for a table without a map.
+  page_id_t page_id = table_id_;
+  if (last_page_id_ != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a table page.");
+    page->RLatch();
+    page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, false);
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a table page.");
+    page->RLatch();
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (!AppendLocked(page_id, free_space)) {
+      // Extending the table walks up to the real last page anyway, the remaining pages just won't get reused.
+      LOG_DEBUG("couldn't create a page for the free space map");
+      break;
+    }
+    page_id = next_page_id;
+  }
+}
+
+bool FreeSpaceMap::AppendLocked(page_id_t page_id, uint32_t free_space) {
+  page_id_t map_page_id = map_page_ids_.empty() ? INVALID_PAGE_ID : map_page_ids_.back();
+  auto page = map_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPage(map_page_id);
+  auto map_page = page == nullptr ? nullptr : reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  if (map_page_id != INVALID_PAGE_ID && page == nullptr) {
+    return false;
+  }
+
+  if (map_page == nullptr || map_page->IsFull()) {
+    // Start a new map page and link it in, from the previous map page or else from the first page of the table.
+    page_id_t new_page_id;
+    auto new_page = buffer_pool_manager_->NewPage(&new_page_id);
+    if (new_page == nullptr) {
+      if (page != nullptr) {
+        buffer_pool_manager_->UnpinPage(map_page_id, false);
+      }
+      return false;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData())->Init(table_id_);
+    if (page != nullptr) {
+      page->WLatch();
+      map_page->SetNextPageId(new_page_id);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(map_page_id, true);
+    } else {
+      auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(table_id_));
+      if (first_page == nullptr) {
+        buffer_pool_manager_->UnpinPage(new_page_id, false);
+        buffer_pool_manager_->DeletePage(new_page_id);
+        return false;
+      }
+      first_page->WLatch();
+      first_page->SetFreeSpaceMapPageId(new_page_id);
+      first_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(table_id_, true);
+    }
+    map_page_ids_.emplace_back(new_page_id);
+    max_categories_.emplace_back(0);
+    map_page_id = new_page_id;
+    page = new_page;
+    map_page = reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData());
+  }
+
+  page->WLatch();
+  uint32_t index = map_page->Append(page_id, free_space);
+  max_categories_.back() = map_page->GetMaxCategory();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+  locations_[page_id] = {map_page_ids_.size() - 1, index};
+  last_page_id_ = page_id;
+  return true;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+  std::scoped_lock latch(latch_);
+  Load();
+  const uint32_t needed = FreeSpaceMapPage::NeededCategory(size);
+  for (size_t i = 0; i < map_page_ids_.size(); i++) {
+    // Only visit a map page that is known to lead to a page with enough room.
+    if (max_categories_[i] < needed) {
+      continue;
+    }
+    auto page = buffer_pool_manager_->FetchPage(map_page_ids_[i]);
+    if (page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    page->RLatch();
+    uint32_t index = map_page->Find(size);
+    page_id_t page_id = index < map_page->GetNumEntries() ? map_page->GetTablePageId(index) : INVALID_PAGE_ID;
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(map_page_ids_[i], false);
+    if (page_id != INVALID_PAGE_ID) {
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock latch(latch_);
+  Load();
+  auto iter = locations_.find(page_id);
+  if (iter == locations_.end()) {
+    return;
+  }
+  auto [map_index, index] = iter->second;
+  auto page = buffer_pool_manager_->FetchPage(map_page_ids_[map_index]);
+  if (page == nullptr) {
+    return;
+  }
+  auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  page->WLatch();
+  map_page->SetFreeSpace(index, free_space);
+  max_categories_[map_index] = map_page->GetMaxCategory();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(map_page_ids_[map_index], true);
+}
+
+bool FreeSpaceMap::Append(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock latch(latch_);
+  Load();
+  return locations_.count(page_id) != 0 || AppendLocked(page_id, free_space);
+}
+
+void FreeSpaceMap::Remove(page_id_t page_id) {
+  std::scoped_lock latch(latch_);
+  Load();
+  auto iter = locations_.find(page_id);
+  if (iter == locations_.end()) {
+    return;
+  }
+  auto [map_index, index] = iter->second;
+  auto page = buffer_pool_manager_->FetchPage(map_page_ids_[map_index]);
+  if (page == nullptr) {
+    // The entry stays and is corrected by the next insert that tries the page.
+    return;
+  }
+  auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  page->WLatch();
+  map_page->Clear(index);
+  max_categories_[map_index] = map_page->GetMaxCategory();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(map_page_ids_[map_index], true);
+  locations_.erase(iter);
+  if (last_page_id_ == page_id) {
+    // Extending the table walks the chain from the first page instead.
+    last_page_id_ = INVALID_PAGE_ID;
+  }
+}
+
+page_id_t FreeSpaceMap::GetLastPageId() {
+  std::scoped_lock latch(latch_);
+  Load();
+  return last_page_id_;
+}
+
+size_t FreeSpaceMap::GetNumPages() {
+  std::scoped_lock latch(latch_);
+  Load();
+  return locations_.size();
+}
+
+}  // namespace bustub
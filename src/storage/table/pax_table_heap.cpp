@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_heap.cpp
+//
+// Identification: src/storage/table/pax_table_heap.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/pax_table_heap.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+PaxTableHeap::PaxTableHeap(BufferPoolManager *buffer_pool_manager, const Schema &schema)
+    : buffer_pool_manager_(buffer_pool_manager), schema_(schema), layout_(schema) {
+  // Initialize the first page.
+  auto *first_page = static_cast<PaxPage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
+  first_page->WLatch();
+  first_page->Init(layout_, first_page_id_, INVALID_PAGE_ID);
+  first_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  last_page_id_ = first_page_id_;
+}
+
+PaxTableHeap::PaxTableHeap(BufferPoolManager *buffer_pool_manager, const Schema &schema, page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), schema_(schema), layout_(schema), first_page_id_(first_page_id) {
+  // Find the last page, where inserts go.
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto *page = static_cast<PaxPage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    const page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    last_page_id_ = page_id;
+    page_id = next_page_id;
+  }
+}
+
+bool PaxTableHeap::InsertTuple(const Tuple &tuple, RID *rid) {
+  std::scoped_lock latch(extend_latch_);
+  auto *last_page = static_cast<PaxPage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+  if (last_page == nullptr) {
+    return false;
+  }
+  last_page->WLatch();
+  if (last_page->InsertTuple(layout_, tuple, rid)) {
+    last_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, true);
+    return true;
+  }
+
+  // The last page is full or sealed, seal it and append a new one.
+  last_page->Seal(layout_);
+  page_id_t new_page_id;
+  auto *new_page = static_cast<PaxPage *>(buffer_pool_manager_->NewPage(&new_page_id));
+  if (new_page == nullptr) {
+    last_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, false);
+    return false;
+  }
+  new_page->WLatch();
+  new_page->Init(layout_, new_page_id, last_page_id_);
+  new_page->InsertTuple(layout_, tuple, rid);
+  new_page->WUnlatch();
+  last_page->SetNextPageId(new_page_id);
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  last_page_id_ = new_page_id;
+  return true;
+}
+
+bool PaxTableHeap::BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids) {
+  std::scoped_lock latch(extend_latch_);
+  auto *last_page = static_cast<PaxPage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+  if (last_page == nullptr) {
+    return false;
+  }
+  last_page->WLatch();
+  // A last page without tuples, like the first page of a new table, becomes the first sealed page.
+  bool reuse_last_page = last_page->GetTupleCount() == 0;
+  if (!reuse_last_page) {
+    last_page->Seal(layout_);
+  }
+
+  const uint32_t tuple_length = layout_.GetTupleLength();
+  std::vector<char> rows;
+  size_t begin = 0;
+  while (begin < tuples.size()) {
+    // Take tuples as long as the sealed page they make fits.
+    std::vector<PaxColumnEncoder> encoders = layout_.CreateEncoders();
+    uint32_t count = 0;
+    bool too_large = false;
+    rows.clear();
+    while (begin + count < tuples.size() && count < PaxPage::MAX_SEALED_TUPLES) {
+      const char *data = tuples[begin + count].GetData();
+      BUSTUB_ASSERT(tuples[begin + count].GetLength() == tuple_length, "The tuple does not have the table's schema.");
+      for (uint32_t i = 0; i < layout_.GetColumnCount(); i++) {
+        encoders[i].Add(data + layout_.GetTupleOffset(i));
+      }
+      if (PaxPage::GetSealedSize(layout_, encoders, count + 1) > PAGE_SIZE) {
+        too_large = true;
+        break;
+      }
+      rows.insert(rows.end(), data, data + tuple_length);
+      count++;
+    }
+    if (too_large) {
+      // The encoders have seen one tuple too many.
+      encoders = layout_.CreateEncoders();
+      for (uint32_t k = 0; k < count; k++) {
+        for (uint32_t i = 0; i < layout_.GetColumnCount(); i++) {
+          encoders[i].Add(rows.data() + k * tuple_length + layout_.GetTupleOffset(i));
+        }
+      }
+    }
+
+    page_id_t page_id = last_page_id_;
+    if (reuse_last_page) {
+      last_page->InitSealed(layout_, page_id, last_page->GetPrevPageId(), rows.data(), count, encoders);
+      reuse_last_page = false;
+    } else {
+      auto *new_page = static_cast<PaxPage *>(buffer_pool_manager_->NewPage(&page_id));
+      if (new_page == nullptr) {
+        last_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(last_page_id_, true);
+        return false;
+      }
+      new_page->WLatch();
+      new_page->InitSealed(layout_, page_id, last_page_id_, rows.data(), count, encoders);
+      last_page->SetNextPageId(page_id);
+      last_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(last_page_id_, true);
+      last_page = new_page;
+      last_page_id_ = page_id;
+    }
+    if (rids != nullptr) {
+      for (uint32_t k = 0; k < count; k++) {
+        rids->emplace_back(page_id, k);
+      }
+    }
+    begin += count;
+  }
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  return true;
+}
+
+bool PaxTableHeap::DeleteTuple(const RID &rid) {
+  auto *page = static_cast<PaxPage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  const bool deleted = page->DeleteTuple(rid);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), deleted);
+  return deleted;
+}
+
+bool PaxTableHeap::GetTuple(const RID &rid, Tuple *tuple) {
+  auto *page = static_cast<PaxPage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  if (page == nullptr) {
+    return false;
+  }
+  page->RLatch();
+  const bool found = page->GetTuple(layout_, rid, tuple);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+  return found;
+}
+
+PaxTableIterator PaxTableHeap::Begin(const std::vector<uint32_t> &column_ids, const PaxPredicate *predicate) {
+  return PaxTableIterator(this, column_ids, first_page_id_, predicate);
+}
+
+PaxTableIterator PaxTableHeap::End() { return PaxTableIterator(this, {}, INVALID_PAGE_ID); }
+
+}  // namespace bustub
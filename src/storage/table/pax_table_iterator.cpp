@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_iterator.cpp
+//
+// Identification: src/storage/table/pax_table_iterator.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/pax_table_iterator.h"
+
+#include "common/macros.h"
+#include "storage/table/pax_table_heap.h"
+
+namespace bustub {
+
+namespace {
+Schema ProjectSchema(const Schema &schema, const std::vector<uint32_t> &column_ids) {
+  std::vector<Column> columns;
+  columns.reserve(column_ids.size());
+  for (uint32_t column_idx : column_ids) {
+    columns.emplace_back(schema.GetColumn(column_idx));
+  }
+  return Schema(columns);
+}
+}  // namespace
+
+PaxTableIterator::PaxTableIterator(PaxTableHeap *table_heap, const std::vector<uint32_t> &column_ids,
+                                   page_id_t page_id, const PaxPredicate *predicate)
+    : table_heap_(table_heap),
+      column_ids_(column_ids),
+      schema_(ProjectSchema(table_heap->GetSchema(), column_ids)),
+      predicate_(predicate) {
+  tuple_.rid_ = RID(INVALID_PAGE_ID, 0);
+  LoadPage(page_id);
+}
+
+PaxTableIterator &PaxTableIterator::operator++() {
+  if (++pos_ < slots_.size()) {
+    SetTuple();
+  } else {
+    LoadPage(next_page_id_);
+  }
+  return *this;
+}
+
+void PaxTableIterator::LoadPage(page_id_t page_id) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->GetBufferPoolManager();
+  const PaxLayout &layout = table_heap_->GetLayout();
+  const uint32_t row_length = schema_.GetLength();
+  while (page_id != INVALID_PAGE_ID) {
+    auto *page = static_cast<PaxPage *>(buffer_pool_manager->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    slots_.clear();
+    const uint32_t tuple_count = page->GetTupleCount();
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      if (page->IsLive(slot_num)) {
+        slots_.emplace_back(slot_num);
+      }
+    }
+    if (predicate_ != nullptr) {
+      page->Filter(layout, *predicate_, &slots_);
+    }
+    rows_.resize(slots_.size() * row_length);
+    for (uint32_t i = 0; i < column_ids_.size(); i++) {
+      page->ReadColumn(layout, column_ids_[i], slots_, rows_.data() + schema_.GetColumn(i).GetOffset(), row_length);
+    }
+    const page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager->UnpinPage(page_id, false);
+
+    if (!slots_.empty()) {
+      page_id_ = page_id;
+      next_page_id_ = next_page_id;
+      pos_ = 0;
+      SetTuple();
+      return;
+    }
+    page_id = next_page_id;
+  }
+  // The end of the table.
+  page_id_ = INVALID_PAGE_ID;
+  slots_.clear();
+  pos_ = 0;
+  tuple_.data_ = nullptr;
+  tuple_.size_ = 0;
+  tuple_.rid_ = RID(INVALID_PAGE_ID, 0);
+}
+
+void PaxTableIterator::SetTuple() {
+  const uint32_t row_length = schema_.GetLength();
+  tuple_.data_ = rows_.data() + pos_ * row_length;
+  tuple_.size_ = row_length;
+  tuple_.rid_ = RID(page_id_, slots_[pos_]);
+}
+
+}  // namespace bustub
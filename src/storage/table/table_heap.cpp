@@ -10,9 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
+#include <vector>
 
 #include "common/logger.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -22,7 +26,14 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id),
+      free_space_map_(std::make_unique<FreeSpaceMap>(buffer_pool_manager, first_page_id)) {}
+
+TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
+                     page_id_t first_page_id, const Schema &schema, Transaction *txn)
+    : TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id) {
+  CreateZoneMap(schema, txn);
+}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
                      Transaction *txn)
@@ -34,64 +45,196 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, first_page_id_);
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
-    txn->SetState(TransactionState::ABORTED);
-    return false;
+  bool inserted;
+  if (!NeedsOverflow(tuple)) {
+    inserted = InsertStored(tuple, rid, txn);
+  } else {
+    // Larger than one page size, move the tail of the tuple out of the way.
+    Tuple stored;
+    if (!WriteOverflow(tuple, &stored)) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    inserted = InsertStored(stored, rid, txn);
+    if (!inserted) {
+      FreeOverflow(stored.overflow_page_id_);
+    }
+  }
+  // The tuple is not committed yet, so it is fine that scans may skip its page until now.
+  if (inserted && zone_map_ != nullptr) {
+    zone_map_->Add(rid->GetPageId(), tuple);
   }
+  return inserted;
+}
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
-    txn->SetState(TransactionState::ABORTED);
-    return false;
+bool TableHeap::WriteOverflow(const Tuple &tuple, Tuple *stored) {
+  const char *data = tuple.GetData();
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  Page *prev_page = nullptr;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  // Fill the chain front to back, so that it is read in the order of its page ids.
+  for (uint32_t offset = OVERFLOW_INLINE_SIZE; offset < tuple.size_; offset += OverflowPage::CAPACITY) {
+    page_id_t page_id;
+    auto page = buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      if (prev_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      }
+      FreeOverflow(first_page_id);
+      return false;
+    }
+    page->WLatch();
+    reinterpret_cast<OverflowPage *>(page->GetData())
+        ->Init(data + offset, std::min<uint32_t>(OverflowPage::CAPACITY, tuple.size_ - offset));
+    page->WUnlatch();
+    if (prev_page == nullptr) {
+      first_page_id = page_id;
+    } else {
+      prev_page->WLatch();
+      reinterpret_cast<OverflowPage *>(prev_page->GetData())->SetNextPageId(page_id);
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    }
+    prev_page = page;
+    prev_page_id = page_id;
   }
+  buffer_pool_manager_->UnpinPage(prev_page_id, true);
 
+  if (stored->allocated_) {
+    delete[] stored->data_;
+  }
+  stored->data_ = const_cast<char *>(data);
+  stored->allocated_ = false;
+  stored->size_ = tuple.size_;
+  stored->rid_ = tuple.rid_;
+  stored->loaded_size_ = OVERFLOW_INLINE_SIZE;
+  stored->overflow_page_id_ = first_page_id;
+  return true;
+}
+
+void TableHeap::FreeOverflow(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      LOG_DEBUG("couldn't fetch an overflow page to free it");
+      return;
+    }
+    page->RLatch();
+    page_id_t next_page_id = reinterpret_cast<OverflowPage *>(page->GetData())->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+bool TableHeap::InsertStored(const Tuple &tuple, RID *rid, Transaction *txn) {
+  const uint32_t needed = TablePage::GetStoredSize(tuple) + TablePage::SIZE_TUPLE;
+  std::unique_lock extend_lock(extend_latch_, std::defer_lock);
+  while (true) {
+    // Ask the free space map for a page with enough space.
+    page_id_t page_id = free_space_map_->FindPage(needed);
+    if (page_id == INVALID_PAGE_ID) {
+      if (!extend_lock.owns_lock()) {
+        // Look again once we are the only one extending the table, somebody may just have added a page.
+        extend_lock.lock();
+        continue;
+      }
+      return ExtendAndInsert(tuple, rid, txn);
+    }
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    page->WLatch();
+    bool inserted = page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+    // Either way the map learns the current free space; if the entry was stale, the next search moves on.
+    free_space_map_->Update(page_id, free_space);
+    if (inserted) {
+      // Update the transaction's write set.
+      txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+      return true;
+    }
+  }
+}
+
+TablePage *TableHeap::FetchLastPage(std::vector<std::pair<page_id_t, uint32_t>> *missed_pages) {
+  page_id_t last_page_id = free_space_map_->GetLastPageId();
+  if (last_page_id == INVALID_PAGE_ID) {
+    last_page_id = first_page_id_;
+  }
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+  if (cur_page == nullptr) {
+    return nullptr;
+  }
   cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
+  while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
     auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
-    } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-        txn->SetState(TransactionState::ABORTED);
-        return false;
-      }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
+    cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    if (cur_page == nullptr) {
+      return nullptr;
     }
+    cur_page->WLatch();
+    missed_pages->emplace_back(next_page_id, cur_page->GetFreeSpaceRemaining());
+  }
+  return cur_page;
+}
+
+bool TableHeap::ExtendAndInsert(const Tuple &tuple, RID *rid, Transaction *txn) {
+  std::vector<std::pair<page_id_t, uint32_t>> missed_pages;
+  auto cur_page = FetchLastPage(&missed_pages);
+  if (cur_page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+
+  page_id_t new_page_id;
+  auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&new_page_id));
+  // If we could not create a new page,
+  if (new_page == nullptr) {
+    // Then life sucks and we abort the transaction.
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // Otherwise we were able to create a new page. We initialize it now.
+  if (zone_map_ != nullptr) {
+    zone_map_->AppendPage(new_page_id);
   }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
+  new_page->WLatch();
+  cur_page->SetNextPageId(new_page_id);
+  new_page->Init(new_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
   cur_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+  // The tuple fits into an empty page, see the size check in InsertTuple.
+  bool inserted = new_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+  BUSTUB_ASSERT(inserted, "A tuple that fits into a page must fit into an empty page.");
+  uint32_t free_space = new_page->GetFreeSpaceRemaining();
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+
+  for (auto [page_id, page_free_space] : missed_pages) {
+    free_space_map_->Append(page_id, page_free_space);
+  }
+  free_space_map_->Append(new_page_id, free_space);
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
-  // TODO(Amadou): remove empty page
+  // Pages left empty are reclaimed by Vacuum().
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
@@ -110,19 +253,47 @@ bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) {
+  // Move the tail of a tuple that is too large out of the way first.
+  Tuple overflow_tuple;
+  const Tuple *stored = &tuple;
+  if (NeedsOverflow(tuple)) {
+    if (!WriteOverflow(tuple, &overflow_tuple)) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    stored = &overflow_tuple;
+  }
+  // Cover the new values before they are in the page.
+  if (zone_map_ != nullptr) {
+    zone_map_->Add(rid.GetPageId(), tuple);
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
+    FreeOverflow(overflow_tuple.overflow_page_id_);
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
   page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  bool is_updated = page->UpdateTuple(*stored, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  if (!is_updated) {
+    FreeOverflow(overflow_tuple.overflow_page_id_);
+  } else {
+    free_space_map_->Update(rid.GetPageId(), free_space);
+    if (old_tuple.overflow_page_id_ != INVALID_PAGE_ID) {
+      // Nothing refers to the old overflow pages anymore; the old tuple needs them no longer once it is loaded.
+      page_id_t old_overflow_page_id = old_tuple.overflow_page_id_;
+      old_tuple.buffer_pool_manager_ = buffer_pool_manager_;
+      old_tuple.GetData();
+      FreeOverflow(old_overflow_page_id);
+    }
+  }
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -136,10 +307,110 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
   page->WLatch();
+  page_id_t overflow_page_id = page->GetOverflowPageId(rid);
   page->ApplyDelete(rid, txn, log_manager_);
   lock_manager_->Unlock(txn, rid);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // The space of the tuple can be reused now.
+  free_space_map_->Update(rid.GetPageId(), free_space);
+  FreeOverflow(overflow_page_id);
+}
+
+TableHeap::VacuumResult TableHeap::Vacuum() {
+  std::scoped_lock vacuum_latch(vacuum_latch_);
+  VacuumResult result;
+
+  // Deallocate the pages earlier vacuums unlinked, unless a scan that started before may still be on its way to one,
+  // or somebody still has it pinned.
+  uint64_t oldest_scan;
+  {
+    std::scoped_lock scan_latch(scan_latch_);
+    oldest_scan = active_scans_.empty() ? scan_epoch_ : *active_scans_.begin();
+  }
+  std::vector<std::pair<page_id_t, uint64_t>> kept_pages;
+  for (const auto &[page_id, epoch] : unlinked_pages_) {
+    if (epoch >= oldest_scan || !buffer_pool_manager_->DeletePage(page_id)) {
+      kept_pages.emplace_back(page_id, epoch);
+    }
+  }
+  unlinked_pages_ = std::move(kept_pages);
+
+  // The free space map is only told afterwards, it must not be called with a table page latched.
+  std::vector<std::pair<page_id_t, uint32_t>> free_spaces;
+  std::vector<page_id_t> removed_page_ids;
+  page_id_t prev_page_id = first_page_id_;
+  auto prev_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+  if (prev_page == nullptr) {
+    return result;
+  }
+  prev_page->WLatch();
+  uint32_t reclaimed = prev_page->Vacuum();
+  result.compacted_pages_ += reclaimed > 0 ? 1 : 0;
+  result.reclaimed_bytes_ += reclaimed;
+  free_spaces.emplace_back(prev_page_id, prev_page->GetFreeSpaceRemaining());
+
+  page_id_t page_id;
+  while ((page_id = prev_page->GetNextPageId()) != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      break;
+    }
+    page->WLatch();
+    reclaimed = page->Vacuum();
+    const page_id_t next_page_id = page->GetNextPageId();
+    TablePage *next_page = nullptr;
+    if (next_page_id != INVALID_PAGE_ID && page->IsEmpty()) {
+      next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    }
+    if (next_page != nullptr) {
+      // Unlink the empty page. It keeps pointing to the next page, for the scans that are still on their way to it.
+      next_page->WLatch();
+      next_page->SetPrevPageId(prev_page_id);
+      next_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(next_page_id, true);
+      prev_page->SetNextPageId(next_page_id);
+      // An insert that found the page in the free space map must not put its tuple there any more.
+      page->Retire();
+      if (zone_map_ != nullptr) {
+        zone_map_->RemovePage(page_id);
+      }
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      removed_page_ids.emplace_back(page_id);
+      result.freed_pages_++;
+      result.reclaimed_bytes_ += PAGE_SIZE;
+      continue;
+    }
+
+    result.compacted_pages_ += reclaimed > 0 ? 1 : 0;
+    result.reclaimed_bytes_ += reclaimed;
+    free_spaces.emplace_back(page_id, page->GetFreeSpaceRemaining());
+    prev_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    prev_page = page;
+    prev_page_id = page_id;
+  }
+  prev_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(prev_page_id, true);
+
+  if (!removed_page_ids.empty()) {
+    // The scans that start from now on cannot reach the removed pages any more.
+    uint64_t epoch;
+    {
+      std::scoped_lock scan_latch(scan_latch_);
+      epoch = scan_epoch_++;
+    }
+    for (page_id_t removed_page_id : removed_page_ids) {
+      free_space_map_->Remove(removed_page_id);
+      unlinked_pages_.emplace_back(removed_page_id, epoch);
+    }
+  }
+  for (const auto &[free_page_id, free_space] : free_spaces) {
+    free_space_map_->Update(free_page_id, free_space);
+  }
+  return result;
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
@@ -149,6 +420,14 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Rollback the delete.
   page->WLatch();
   page->RollbackDelete(rid, txn, log_manager_);
+  if (zone_map_ != nullptr) {
+    // The zone map may have been created while the delete was pending, and then left the tuple out.
+    Tuple tuple;
+    tuple.buffer_pool_manager_ = buffer_pool_manager_;
+    if (page->GetTupleView(rid, &tuple, txn, lock_manager_)) {
+      zone_map_->Add(rid.GetPageId(), tuple);
+    }
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
@@ -162,6 +441,7 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
     return false;
   }
   // Read the tuple from the page.
+  tuple->buffer_pool_manager_ = buffer_pool_manager_;
   page->RLatch();
   bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
   page->RUnlatch();
@@ -169,16 +449,174 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
   return res;
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
-  // Start an iterator from the first page.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  page->RLatch();
+bool TableHeap::BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) {
+  if (tuples.empty()) {
+    return true;
+  }
+  // Move the tails of the tuples that are too large out of the way first, stored_tuples[i] is what gets appended.
+  std::vector<Tuple> overflow_tuples(tuples.size());
+  std::vector<const Tuple *> stored_tuples(tuples.size());
+  for (size_t i = 0; i < tuples.size(); i++) {
+    stored_tuples[i] = &tuples[i];
+    if (NeedsOverflow(tuples[i])) {
+      if (!WriteOverflow(tuples[i], &overflow_tuples[i])) {
+        for (const auto &overflow_tuple : overflow_tuples) {
+          FreeOverflow(overflow_tuple.overflow_page_id_);
+        }
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+      stored_tuples[i] = &overflow_tuples[i];
+    }
+  }
+
+  std::scoped_lock extend_lock(extend_latch_);
+  std::vector<std::pair<page_id_t, uint32_t>> new_pages;
+  auto cur_page = FetchLastPage(&new_pages);
+  if (cur_page == nullptr) {
+    for (const auto &overflow_tuple : overflow_tuples) {
+      FreeOverflow(overflow_tuple.overflow_page_id_);
+    }
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  const page_id_t last_page_id = cur_page->GetTablePageId();
+  uint32_t last_page_free_space = 0;
+  bool complete = true;
   RID rid;
-  // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-  page->GetFirstTupleRid(&rid);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  size_t i = 0;
+  // Fill the last page, then one fresh page after the other. INVARIANT: cur_page is WLatched.
+  while (true) {
+    for (; i < tuples.size() && cur_page->AppendTuple(*stored_tuples[i], &rid); i++) {
+      if (zone_map_ != nullptr) {
+        zone_map_->Add(rid.GetPageId(), tuples[i]);
+      }
+      if (rids != nullptr) {
+        rids->emplace_back(rid);
+      }
+    }
+    TablePage *new_page = nullptr;
+    page_id_t new_page_id = INVALID_PAGE_ID;
+    if (i < tuples.size()) {
+      new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&new_page_id));
+      complete = new_page != nullptr;
+    }
+    if (new_page != nullptr) {
+      if (zone_map_ != nullptr) {
+        zone_map_->AppendPage(new_page_id);
+      }
+      new_page->WLatch();
+      cur_page->SetNextPageId(new_page_id);
+      new_page->Init(new_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
+    }
+    if (enable_logging) {
+      cur_page->LogPageImage(txn, log_manager_);
+    }
+    if (cur_page->GetTablePageId() == last_page_id) {
+      last_page_free_space = cur_page->GetFreeSpaceRemaining();
+    } else {
+      new_pages.emplace_back(cur_page->GetTablePageId(), cur_page->GetFreeSpaceRemaining());
+    }
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+    if (new_page == nullptr) {
+      break;
+    }
+    cur_page = new_page;
+  }
+
+  // The pages the map missed come first, among them possibly the last page, so the update goes after them.
+  for (auto [page_id, free_space] : new_pages) {
+    free_space_map_->Append(page_id, free_space);
+  }
+  free_space_map_->Update(last_page_id, last_page_free_space);
+  if (!complete) {
+    for (; i < tuples.size(); i++) {
+      FreeOverflow(overflow_tuples[i].overflow_page_id_);
+    }
+    txn->SetState(TransactionState::ABORTED);
+  }
+  return complete;
+}
+
+TableIterator TableHeap::Begin(Transaction *txn, BufferRing *ring, uint32_t readahead_window, bool zero_copy,
+                               const ZoneMap::Predicate *predicate) {
+  // Start an iterator from the first page that has a tuple, and is not skipped. The scan is registered before the first
+  // link is read, so a vacuum does not deallocate a page the scan may still go to.
+  const uint64_t epoch = EnterScan();
+  const ZoneMap::Predicate *skip = zone_map_ != nullptr ? predicate : nullptr;
+  page_id_t page_id = skip != nullptr ? zone_map_->SkipPages(first_page_id_, *skip) : first_page_id_;
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  RID rid;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageWithRing(page_id, ring));
+    page->RLatch();
+    // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
+    bool found = page->GetFirstTupleRid(&rid);
+    next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (found) {
+      break;
+    }
+    page_id = skip != nullptr ? zone_map_->SkipPages(next_page_id, *skip) : next_page_id;
+  }
+  TableIterator iter(this, rid, txn, ring, readahead_window, zero_copy, skip);
+  if (rid.GetPageId() != INVALID_PAGE_ID) {
+    // The iterator ends the scan once it is done.
+    iter.in_scan_ = true;
+    iter.scan_epoch_ = epoch;
+  } else {
+    LeaveScan(epoch);
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    iter.ReadAhead(page_id, next_page_id);
+  }
+  return iter;
+}
+
+uint64_t TableHeap::EnterScan() {
+  std::scoped_lock scan_latch(scan_latch_);
+  active_scans_.emplace(scan_epoch_);
+  return scan_epoch_;
+}
+
+void TableHeap::EnterScan(uint64_t epoch) {
+  std::scoped_lock scan_latch(scan_latch_);
+  active_scans_.emplace(epoch);
+}
+
+void TableHeap::LeaveScan(uint64_t epoch) {
+  std::scoped_lock scan_latch(scan_latch_);
+  active_scans_.erase(active_scans_.find(epoch));
+}
+
+void TableHeap::CreateZoneMap(const Schema &schema, Transaction *txn) {
+  auto zone_map = std::make_unique<ZoneMap>(schema);
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a table page.");
+    page->RLatch();
+    zone_map->AppendPage(page_id);
+    // A tuple with a pending delete is left out; should the delete be rolled back, RollbackDelete adds it.
+    RID rid;
+    bool found = page->GetFirstTupleRid(&rid);
+    while (found) {
+      Tuple tuple;
+      tuple.buffer_pool_manager_ = buffer_pool_manager_;
+      if (page->GetTupleView(rid, &tuple, txn, lock_manager_)) {
+        zone_map->Add(page_id, tuple);
+      }
+      RID next_rid;
+      found = page->GetNextTupleRid(rid, &next_rid);
+      rid = next_rid;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  zone_map_ = std::move(zone_map);
 }
 
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
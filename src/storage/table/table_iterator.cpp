@@ -10,60 +10,244 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring,
+                             uint32_t readahead_window, bool zero_copy, const ZoneMap::Predicate *predicate)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(rid)),
+      txn_(txn),
+      ring_(ring),
+      readahead_window_(readahead_window),
+      zero_copy_(zero_copy),
+      predicate_(predicate) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    page_ = static_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPageWithRing(rid.GetPageId(), ring_));
+    if (page_ == nullptr) {
+      txn_->SetState(TransactionState::ABORTED);
+      return;
+    }
+    page_->RLatch();
+    latched_ = true;
+    LoadTuple();
+  }
+}
+
+TableIterator::TableIterator(const TableIterator &other)
+    : table_heap_(other.table_heap_),
+      tuple_(new Tuple(other.tuple_->rid_)),
+      txn_(other.txn_),
+      ring_(other.ring_),
+      readahead_window_(other.readahead_window_),
+      readahead_end_(other.readahead_end_),
+      zero_copy_(other.zero_copy_),
+      predicate_(other.predicate_),
+      in_scan_(other.in_scan_),
+      scan_epoch_(other.scan_epoch_) {
+  CopyTuple(*other.tuple_);
+  if (in_scan_) {
+    table_heap_->EnterScan(scan_epoch_);
   }
 }
 
+TableIterator::TableIterator(TableIterator &&other) noexcept
+    : table_heap_(other.table_heap_),
+      tuple_(other.tuple_),
+      txn_(other.txn_),
+      ring_(other.ring_),
+      readahead_window_(other.readahead_window_),
+      readahead_end_(other.readahead_end_),
+      zero_copy_(other.zero_copy_),
+      predicate_(other.predicate_),
+      page_(other.page_),
+      latched_(other.latched_),
+      in_scan_(other.in_scan_),
+      scan_epoch_(other.scan_epoch_) {
+  other.tuple_ = nullptr;
+  other.page_ = nullptr;
+  other.latched_ = false;
+  other.in_scan_ = false;
+}
+
+TableIterator &TableIterator::operator=(const TableIterator &other) {
+  if (this == &other) {
+    return *this;
+  }
+  ReleasePage();
+  LeaveScan();
+  table_heap_ = other.table_heap_;
+  tuple_->rid_ = other.tuple_->rid_;
+  CopyTuple(*other.tuple_);
+  txn_ = other.txn_;
+  ring_ = other.ring_;
+  readahead_window_ = other.readahead_window_;
+  readahead_end_ = other.readahead_end_;
+  zero_copy_ = other.zero_copy_;
+  predicate_ = other.predicate_;
+  in_scan_ = other.in_scan_;
+  scan_epoch_ = other.scan_epoch_;
+  if (in_scan_) {
+    table_heap_->EnterScan(scan_epoch_);
+  }
+  return *this;
+}
+
+TableIterator::~TableIterator() {
+  ReleasePage();
+  LeaveScan();
+  delete tuple_;
+}
+
 const Tuple &TableIterator::operator*() {
   assert(*this != table_heap_->End());
+  assert(!zero_copy_ || latched_ || tuple_->allocated_);  // a released view is gone
   return *tuple_;
 }
 
 Tuple *TableIterator::operator->() {
   assert(*this != table_heap_->End());
+  assert(!zero_copy_ || latched_ || tuple_->allocated_);  // a released view is gone
   return tuple_;
 }
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  if (page_ == nullptr) {
+    // A copying iterator, or a copy of an iterator, it does not hold its page.
+    page_ = static_cast<TablePage *>(buffer_pool_manager->FetchPageWithRing(tuple_->rid_.GetPageId(), ring_));
+    assert(page_ != nullptr);  // all pages are pinned
+  }
+  if (!latched_) {
+    page_->RLatch();
+    latched_ = true;
+  }
 
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+  if (!page_->GetNextTupleRid(tuple_->rid_,
+                              &next_tuple_rid)) {  // end of this page
+    for (page_id_t next_page_id = SkipPages(page_->GetNextPageId()); next_page_id != INVALID_PAGE_ID;
+         next_page_id = SkipPages(page_->GetNextPageId())) {
+      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPageWithRing(next_page_id, ring_));
+      page_->RUnlatch();
+      buffer_pool_manager->UnpinPage(page_->GetTablePageId(), false);
+      page_ = next_page;
+      page_->RLatch();
+      ReadAhead(page_->GetTablePageId(), page_->GetNextPageId());
+      if (page_->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
     }
   }
   tuple_->rid_ = next_tuple_rid;
 
-  if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+  if (tuple_->rid_.GetPageId() != INVALID_PAGE_ID) {
+    LoadTuple();
+  } else {
+    ReleasePage();
+    LeaveScan();
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
+void TableIterator::Release() {
+  if (!latched_) {
+    return;
+  }
+  if (!tuple_->allocated_) {
+    tuple_->data_ = nullptr;
+    tuple_->size_ = 0;
+    tuple_->overflow_page_id_ = INVALID_PAGE_ID;
+  } else {
+    // A view that was partly loaded stays, the overflow pages may be freed once the page is unlatched.
+    tuple_->LoadOverflow(tuple_->size_);
+  }
+  page_->RUnlatch();
+  latched_ = false;
+}
+
+void TableIterator::LoadTuple() {
+  if (zero_copy_) {
+    if (!tuple_->allocated_) {
+      // Don't leave a view into the previous page behind if the read fails.
+      tuple_->data_ = nullptr;
+      tuple_->size_ = 0;
+      tuple_->overflow_page_id_ = INVALID_PAGE_ID;
+    }
+    tuple_->buffer_pool_manager_ = table_heap_->buffer_pool_manager_;
+    page_->GetTupleView(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
+    return;
+  }
+  tuple_->buffer_pool_manager_ = table_heap_->buffer_pool_manager_;
+  page_->GetTuple(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
+  // The copy does not need the page any more. Open iterators do not hold on to frames, the next increment fetches
+  // the page again.
+  ReleasePage();
+}
+
+void TableIterator::ReleasePage() {
+  if (page_ == nullptr) {
+    return;
+  }
+  Release();
+  table_heap_->buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+  page_ = nullptr;
+}
+
+void TableIterator::LeaveScan() {
+  if (in_scan_) {
+    table_heap_->LeaveScan(scan_epoch_);
+    in_scan_ = false;
+  }
+}
+
+void TableIterator::CopyTuple(const Tuple &tuple) {
+  *tuple_ = tuple;
+  tuple_->Materialize();
+}
+
+void TableIterator::ReadAhead(page_id_t page_id, page_id_t next_page_id) {
+  if (readahead_window_ == 0 || next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  auto window = static_cast<page_id_t>(readahead_window_);
+  if (ring_ != nullptr) {
+    // Leave a frame of the ring to the page the scan is on, the window must not recycle the pages it prefetched.
+    window = std::min(window, static_cast<page_id_t>(ring_->GetRingSize()) - 1);
+    if (window <= 0) {
+      return;
+    }
+  }
+  std::vector<page_id_t> page_ids;
+  if (next_page_id != page_id + 1) {
+    // The chain does not continue with the next page id here, only the link that was read is certain. The guess
+    // starts over once the chain is consecutive again.
+    page_ids.emplace_back(next_page_id);
+    readahead_end_ = next_page_id + 1;
+  } else {
+    if (next_page_id + window / 2 < readahead_end_) {
+      return;
+    }
+    for (page_id_t id = std::max(next_page_id, readahead_end_); id < next_page_id + window; id++) {
+      page_ids.emplace_back(id);
+    }
+    readahead_end_ = next_page_id + window;
+  }
+  table_heap_->buffer_pool_manager_->PrefetchPages(page_ids, ring_);
+}
+
+page_id_t TableIterator::SkipPages(page_id_t page_id) {
+  if (predicate_ == nullptr || page_id == INVALID_PAGE_ID) {
+    return page_id;
+  }
+  return table_heap_->zone_map_->SkipPages(page_id, *predicate_);
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
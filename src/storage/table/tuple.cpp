@@ -16,6 +16,8 @@
 #include <string>
 #include <vector>
 
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -53,40 +55,88 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
-  if (allocated_) {
-    delete[] data_;
-  }
+Tuple::Tuple(const Tuple &other)
+    : allocated_(other.allocated_),
+      rid_(other.rid_),
+      size_(other.size_),
+      overflow_page_id_(other.overflow_page_id_),
+      loaded_size_(other.loaded_size_),
+      buffer_pool_manager_(other.buffer_pool_manager_) {
   if (allocated_) {
     // Deep copy.
     data_ = new char[size_];
-    memcpy(data_, other.data_, size_);
+    memcpy(data_, other.data_, GetLoadedSize());
   } else {
     // Shallow copy.
     data_ = other.data_;
   }
+  // The copy may outlive the latch that keeps the overflow pages from being freed.
+  if (buffer_pool_manager_ != nullptr) {
+    LoadOverflow(size_);
+  }
 }
 
 Tuple &Tuple::operator=(const Tuple &other) {
+  if (this == &other) {
+    return *this;
+  }
   if (allocated_) {
     delete[] data_;
   }
   allocated_ = other.allocated_;
   rid_ = other.rid_;
   size_ = other.size_;
+  overflow_page_id_ = other.overflow_page_id_;
+  loaded_size_ = other.loaded_size_;
+  buffer_pool_manager_ = other.buffer_pool_manager_;
 
   if (allocated_) {
     // Deep copy.
     data_ = new char[size_];
-    memcpy(data_, other.data_, size_);
+    memcpy(data_, other.data_, GetLoadedSize());
   } else {
     // Shallow copy.
     data_ = other.data_;
   }
+  // The copy may outlive the latch that keeps the overflow pages from being freed.
+  if (buffer_pool_manager_ != nullptr) {
+    LoadOverflow(size_);
+  }
 
   return *this;
 }
 
+void Tuple::Materialize() const {
+  if (allocated_ || data_ == nullptr) {
+    return;
+  }
+  auto data = new char[size_];
+  memcpy(data, data_, GetLoadedSize());
+  data_ = data;
+  allocated_ = true;
+}
+
+void Tuple::LoadOverflow(uint32_t end) const {
+  if (overflow_page_id_ == INVALID_PAGE_ID || end <= loaded_size_) {
+    return;
+  }
+  BUSTUB_ASSERT(buffer_pool_manager_ != nullptr, "A tuple with overflow pages must know its buffer pool.");
+  // The loaded bytes may still be in the table page, the tuple needs all of its bytes in one place.
+  Materialize();
+  while (loaded_size_ < end && overflow_page_id_ != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(overflow_page_id_);
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch an overflow page.");
+    auto overflow_page = reinterpret_cast<const OverflowPage *>(page->GetData());
+    page->RLatch();
+    memcpy(data_ + loaded_size_, overflow_page->GetData(), overflow_page->GetSize());
+    loaded_size_ += overflow_page->GetSize();
+    page_id_t next_page_id = overflow_page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(overflow_page_id_, false);
+    overflow_page_id_ = next_page_id;
+  }
+}
+
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
@@ -103,10 +153,20 @@ const char *Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) c
   bool is_inlined = col.IsInlined();
   // For inline type, data is stored where it is.
   if (is_inlined) {
+    LoadOverflow(col.GetOffset() + col.GetFixedLength());
     return (data_ + col.GetOffset());
   }
   // We read the relative offset from the tuple data.
+  LoadOverflow(col.GetOffset() + sizeof(int32_t));
   int32_t offset = *reinterpret_cast<int32_t *>(data_ + col.GetOffset());
+  // The payload may be in overflow pages, load its size and then the payload itself.
+  if (overflow_page_id_ != INVALID_PAGE_ID) {
+    LoadOverflow(offset + sizeof(uint32_t));
+    uint32_t length = *reinterpret_cast<uint32_t *>(data_ + offset);
+    if (length != BUSTUB_VALUE_NULL) {
+      LoadOverflow(offset + sizeof(uint32_t) + length);
+    }
+  }
   // And return the beginning address of the real data for the VARCHAR type.
   return (data_ + offset);
 }
@@ -138,7 +198,7 @@ std::string Tuple::ToString(const Schema *schema) const {
 
 void Tuple::SerializeTo(char *storage) const {
   memcpy(storage, &size_, sizeof(int32_t));
-  memcpy(storage + sizeof(int32_t), data_, size_);
+  memcpy(storage + sizeof(int32_t), GetData(), size_);
 }
 
 void Tuple::DeserializeFrom(const char *storage) {
@@ -151,6 +211,7 @@ void Tuple::DeserializeFrom(const char *storage) {
   this->data_ = new char[this->size_];
   memcpy(this->data_, storage + sizeof(int32_t), this->size_);
   this->allocated_ = true;
+  this->overflow_page_id_ = INVALID_PAGE_ID;
 }
 
 }  // namespace bustub
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include <utility>
+
+#include "type/value_factory.h"
+
+namespace bustub {
+
+ZoneMap::ZoneMap(const Schema &schema) : schema_(schema) {}
+
+void ZoneMap::AppendPage(page_id_t page_id) {
+  PageSummary page_summary;
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    const TypeId type = schema_.GetColumn(i).GetType();
+    page_summary.columns_.emplace_back(
+        ColumnSummary{ValueFactory::GetNullValueByType(type), ValueFactory::GetNullValueByType(type), 0});
+  }
+  std::scoped_lock latch(latch_);
+  if (pages_.count(page_id) != 0) {
+    return;
+  }
+  page_summary.index_ = page_ids_.size();
+  page_ids_.emplace_back(page_id);
+  pages_.emplace(page_id, std::move(page_summary));
+}
+
+void ZoneMap::RemovePage(page_id_t page_id) {
+  std::scoped_lock latch(latch_);
+  auto iter = pages_.find(page_id);
+  if (iter == pages_.end()) {
+    return;
+  }
+  page_ids_[iter->second.index_] = INVALID_PAGE_ID;
+  pages_.erase(iter);
+}
+
+void ZoneMap::Add(page_id_t page_id, const Tuple &tuple) {
+  // Read the values before taking the latch, reading a large tuple may go to its overflow pages.
+  std::vector<Value> values;
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    if (IsSummarized(i)) {
+      values.emplace_back(tuple.GetValue(&schema_, i));
+    }
+  }
+
+  std::scoped_lock latch(latch_);
+  auto iter = pages_.find(page_id);
+  if (iter == pages_.end()) {
+    // Never skipped anyway.
+    return;
+  }
+  auto value_iter = values.begin();
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    if (!IsSummarized(i)) {
+      continue;
+    }
+    ColumnSummary &summary = iter->second.columns_[i];
+    const Value &value = *value_iter++;
+    if (value.IsNull()) {
+      summary.null_count_++;
+      continue;
+    }
+    if (summary.min_.IsNull() || value.CompareLessThan(summary.min_) == CmpBool::CmpTrue) {
+      summary.min_ = value;
+    }
+    if (summary.max_.IsNull() || value.CompareGreaterThan(summary.max_) == CmpBool::CmpTrue) {
+      summary.max_ = value;
+    }
+  }
+}
+
+bool ZoneMap::GetSummary(page_id_t page_id, uint32_t column_idx, ColumnSummary *summary) {
+  if (!IsSummarized(column_idx)) {
+    return false;
+  }
+  std::scoped_lock latch(latch_);
+  auto iter = pages_.find(page_id);
+  if (iter == pages_.end()) {
+    return false;
+  }
+  *summary = iter->second.columns_[column_idx];
+  return true;
+}
+
+page_id_t ZoneMap::SkipPages(page_id_t page_id, const Predicate &predicate) {
+  if (!IsSummarized(predicate.column_idx_)) {
+    return page_id;
+  }
+  std::scoped_lock latch(latch_);
+  while (page_id != INVALID_PAGE_ID) {
+    auto iter = pages_.find(page_id);
+    if (iter == pages_.end() || predicate.may_match_(iter->second.columns_[predicate.column_idx_])) {
+      return page_id;
+    }
+    size_t next = iter->second.index_ + 1;
+    while (next < page_ids_.size() && page_ids_[next] == INVALID_PAGE_ID) {
+      next++;
+    }
+    page_id = next < page_ids_.size() ? page_ids_[next] : INVALID_PAGE_ID;
+  }
+  return INVALID_PAGE_ID;
+}
+
+}  // namespace bustub
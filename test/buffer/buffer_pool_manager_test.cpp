@@ -10,8 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
+#include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -74,4 +79,356 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PartitionedTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_instances);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: consecutive page ids are spread over the partitions, so the whole pool can be filled.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.emplace_back(page_id);
+  }
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id_temp);
+
+  // Scenario: after unpinning everything, new pages evict the old ones and the old content survives the round trip.
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: concurrent fetches of every page from several threads see the right content.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; tid++) {
+    threads.emplace_back([bpm, &page_ids]() {
+      for (int round = 0; round < 50; round++) {
+        for (auto page_id : page_ids) {
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          page->RLatch();
+          EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+          page->RUnlatch();
+          EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: unpinning a page that is not in the pool fails.
+  EXPECT_FALSE(bpm->UnpinPage(1000, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentHitTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t hot_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&hot_page_id));
+  snprintf(bpm->GetPages()[0].GetData(), PAGE_SIZE, "Hot");
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, true));
+
+  // Scenario: many threads pin and unpin the same resident page, no pin may get lost.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 8; tid++) {
+    threads.emplace_back([bpm, hot_page_id]() {
+      for (int i = 0; i < 10000; i++) {
+        auto *page = bpm->FetchPage(hot_page_id);
+        EXPECT_NE(nullptr, page);
+        EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, bpm->GetPages()[0].GetPinCount());
+  EXPECT_FALSE(bpm->UnpinPage(hot_page_id, false));
+
+  // Scenario: a page that was re-pinned after being unpinned must not be chosen as a victim.
+  auto *hot_page = bpm->FetchPage(hot_page_id);
+  page_id_t page_id_temp;
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(0, strcmp(hot_page->GetData(), "Hot"));
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+
+  // Scenario: once unpinned, the hot page is evictable again.
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, log_manager);
+
+  auto wait_for_background_writes = [bpm](size_t num_writes) {
+    for (int i = 0; i < 500 && bpm->GetNumBackgroundWrites() < num_writes; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return bpm->GetNumBackgroundWrites();
+  };
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + PAGE_SIZE / 2, PAGE_SIZE / 2, "page %d", page_id);
+    page_ids.emplace_back(page_id);
+  }
+
+  // Scenario: with logging enabled, pages whose LSN is not persistent yet must not be written.
+  enable_logging = true;
+  for (auto page_id : page_ids) {
+    bpm->GetPages()[page_id].SetLSN(page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  log_manager->SetPersistentLSN(4);
+  bpm->StartBackgroundWriter(buffer_pool_size);
+  EXPECT_EQ(5, wait_for_background_writes(5));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(5, bpm->GetNumBackgroundWrites());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(page_ids[i] > 4, bpm->GetPages()[i].IsDirty());
+  }
+
+  // Scenario: once the log has caught up, the rest is written as well and new pages evict without writing.
+  log_manager->SetPersistentLSN(100);
+  EXPECT_EQ(buffer_pool_size, wait_for_background_writes(buffer_pool_size));
+  enable_logging = false;
+  bpm->StopBackgroundWriter();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_EQ(0, bpm->GetNumForegroundWrites());
+
+  // Scenario: the written pages have the right content.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids.back() + 1 + static_cast<page_id_t>(i), false));
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData() + PAGE_SIZE / 2, ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: without the background writer, evicting dirty pages is done by the foreground.
+  size_t num_foreground_writes = bpm->GetNumForegroundWrites();
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_foreground_writes + buffer_pool_size, bpm->GetNumForegroundWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  // Try both the plain and the huge page backed frames, over a data file opened with O_DIRECT if possible.
+  for (bool use_huge_pages : {false, true}) {
+    auto *disk_manager = new DiskManager(db_name, true, true);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 1, ReplacerType::CLOCK,
+                                      LRUK_REPLACER_K, use_huge_pages);
+
+    // Scenario: every frame is aligned for direct I/O.
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages()[i].GetData()) % 4096);
+    }
+
+    // Scenario: pages survive being evicted and read back.
+    for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size * 2); page_id++) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+
+  // Scenario: creating and deleting pages keeps reusing the same few page ids, so the file stays small.
+  std::vector<page_id_t> live;
+  for (int round = 0; round < 1000; round++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    live.emplace_back(page_id);
+    if (live.size() == 2 * buffer_pool_size) {
+      bpm->FlushAllPages();
+      for (size_t i = 0; i < live.size(); i += 2) {
+        EXPECT_TRUE(bpm->DeletePage(live[i]));
+      }
+      for (size_t i = 1; i < live.size(); i += 2) {
+        live[i / 2] = live[i];
+      }
+      live.resize(buffer_pool_size);
+    }
+  }
+  bpm->FlushAllPages();
+  EXPECT_LE(disk_manager->GetNumPages(), static_cast<int>(2 * buffer_pool_size));
+  for (auto page_id : live) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a page id that comes back while a stale copy of the page is still cached (e.g. loaded by readahead)
+  // yields a fresh, zeroed page.
+  while (disk_manager->GetNumFreePages() > 0) {
+    disk_manager->AllocatePage();
+  }
+  page_id_t stale_page_id = live.front();
+  ASSERT_NE(nullptr, bpm->FetchPage(stale_page_id));
+  EXPECT_TRUE(bpm->UnpinPage(stale_page_id, false));
+  disk_manager->DeallocatePage(stale_page_id);
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(stale_page_id, page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+
+// Measures FetchPage/UnpinPage throughput on a fully cached working set with a growing number of threads, once with
+// a single partition and once with one partition per thread.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DISABLED_ConcurrentFetchBenchmark) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 256;
+  const int ops_per_thread = 200000;
+  const size_t max_threads = std::max(2U, std::thread::hardware_concurrency());
+
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::vector<size_t> instance_counts{1};
+    if (num_threads > 1) {
+      instance_counts.emplace_back(num_threads);
+    }
+    for (size_t num_instances : instance_counts) {
+      auto *disk_manager = new DiskManager(db_name);
+      auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_instances);
+      std::vector<page_id_t> page_ids;
+      for (size_t i = 0; i < buffer_pool_size; ++i) {
+        page_id_t page_id;
+        ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+        bpm->UnpinPage(page_id, true);
+        page_ids.emplace_back(page_id);
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (size_t tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([bpm, &page_ids, tid]() {
+          std::mt19937 gen(tid);
+          std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+          for (int i = 0; i < ops_per_thread; i++) {
+            page_id_t page_id = page_ids[dist(gen)];
+            bpm->FetchPage(page_id);
+            bpm->UnpinPage(page_id, false);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "threads: " << num_threads << ", instances: " << num_instances
+                << ", fetch+unpin/s: " << static_cast<double>(num_threads * ops_per_thread) / elapsed.count()
+                << std::endl;
+
+      disk_manager->ShutDown();
+      remove("test.db");
+      delete bpm;
+      delete disk_manager;
+    }
+  }
+}
+
 }  // namespace bustub
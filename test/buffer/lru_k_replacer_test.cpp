@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Frame 1 is accessed twice.
+  lru_replacer.Unpin(1);
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  lru_replacer.Unpin(4);
+  lru_replacer.Unpin(5);
+  lru_replacer.Unpin(6);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frames with a single access go first, least recently accessed first.
+  int value;
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  lru_replacer.Pin(3);
+  lru_replacer.Pin(4);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: access 5 a second time. 6 is now the only frame with a single access.
+  lru_replacer.Unpin(5);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+
+  // Scenario: among frames with two accesses, the one whose second most recent access is oldest goes first.
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, RepinnedVictimTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(3, disk_manager, nullptr, 1, ReplacerType::LRU_K, 2);
+
+  // Pages 0 to 2 are accessed twice each, page 0 first.
+  page_id_t page_ids[6];
+  for (int i = 0; i < 3; i++) {
+    bpm->NewPage(&page_ids[i]);
+    bpm->UnpinPage(page_ids[i], true);
+    bpm->FetchPage(page_ids[i]);
+    bpm->UnpinPage(page_ids[i], false);
+  }
+
+  // A hit pins page 0 again without telling the replacer, which still offers its frame as the first victim. The new
+  // page takes the frame of page 1 instead.
+  bpm->FetchPage(page_ids[0]);
+  bpm->NewPage(&page_ids[3]);
+  bpm->UnpinPage(page_ids[3], true);
+  bpm->UnpinPage(page_ids[0], false);
+
+  // Page 0 keeps its accesses, the pages that were accessed only once go first.
+  for (int i = 4; i < 6; i++) {
+    bpm->NewPage(&page_ids[i]);
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  const int reads_before = disk_manager->GetNumReads();
+  bpm->FetchPage(page_ids[0]);
+  bpm->UnpinPage(page_ids[0], false);
+  bpm->FetchPage(page_ids[2]);
+  bpm->UnpinPage(page_ids[2], false);
+  EXPECT_EQ(reads_before, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+namespace {
+
+/**
+ * Runs a mix of a repeated sequential scan over scan_pages pages and random lookups into hot_pages pages against a
+ * buffer pool with the given policy. @return the fraction of the lookups that hit the buffer pool.
+ */
+double LookupHitRatio(ReplacerType replacer_type, size_t pool_size, size_t scan_pages, size_t hot_pages,
+                      int rounds) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(pool_size, disk_manager, nullptr, 1, replacer_type);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < scan_pages + hot_pages; i++) {
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, true);
+    page_ids.emplace_back(page_id);
+  }
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> hot_dist(scan_pages, scan_pages + hot_pages - 1);
+  int lookups = 0;
+  int lookup_misses = 0;
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < scan_pages; i++) {
+      bpm->FetchPage(page_ids[i]);
+      bpm->UnpinPage(page_ids[i], false);
+      // Four point lookups per scanned page.
+      for (int j = 0; j < 4; j++) {
+        page_id_t page_id = page_ids[hot_dist(gen)];
+        int reads_before = disk_manager->GetNumReads();
+        bpm->FetchPage(page_id);
+        bpm->UnpinPage(page_id, false);
+        lookup_misses += disk_manager->GetNumReads() - reads_before;
+        lookups++;
+      }
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+  return 1.0 - static_cast<double>(lookup_misses) / lookups;
+}
+
+}  // namespace
+
+// Compares the hit ratio of hot-set lookups that are interleaved with large sequential scans.
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, DISABLED_ScanLookupHitRatioBenchmark) {
+  const size_t pool_size = 64;
+  const size_t hot_pages = 48;
+  for (size_t scan_pages : {256, 1024}) {
+    double clock_ratio = LookupHitRatio(ReplacerType::CLOCK, pool_size, scan_pages, hot_pages, 4);
+    double lru_k_ratio = LookupHitRatio(ReplacerType::LRU_K, pool_size, scan_pages, hot_pages, 4);
+    std::cout << "scan pages: " << scan_pages << ", lookup hit ratio clock: " << clock_ratio
+              << ", lru-" << LRUK_REPLACER_K << ": " << lru_k_ratio << std::endl;
+    EXPECT_GE(lru_k_ratio, clock_ratio);
+  }
+}
+
+}  // namespace bustub
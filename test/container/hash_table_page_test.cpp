@@ -10,7 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -52,6 +56,21 @@ TEST(HashTablePageTest, HeaderPageSampleTest) {
     EXPECT_EQ(i, header_page->GetBlockPageId(i));
   }
 
+  // drop the blocks of the buckets a resize moved away from
+  header_page->SetOldSize(100);
+  EXPECT_EQ(100, header_page->GetOldSize());
+  header_page->SetMovedBuckets(50);
+  EXPECT_EQ(50, header_page->GetMovedBuckets());
+  header_page->SetNumPairs(70);
+  EXPECT_EQ(70, header_page->GetNumPairs());
+  header_page->SetNumTombstones(20);
+  EXPECT_EQ(20, header_page->GetNumTombstones());
+  header_page->RemoveBlockPageIds(4);
+  EXPECT_EQ(6, header_page->NumBlocks());
+  for (int i = 0; i < 6; i++) {
+    EXPECT_EQ(i + 4, header_page->GetBlockPageId(i));
+  }
+
   // unpin the header page now that we are done
   bpm->UnpinPage(header_page_id, true, nullptr);
   disk_manager->ShutDown();
@@ -111,4 +130,158 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BlockPageSearchTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  auto block_page =
+      reinterpret_cast<HashTableBlockPage<int, int, IntComparator> *>(bpm->NewPage(&block_page_id, nullptr)->GetData());
+  const slot_offset_t num_slots = 4 * PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1);
+
+  // readable, tombstone or never occupied, at random
+  std::mt19937 generator(15445);
+  for (slot_offset_t i = 0; i < num_slots; i++) {
+    const auto kind = generator() % 3;
+    if (kind != 0) {
+      block_page->Insert(i, i, i);
+    }
+    if (kind == 2) {
+      block_page->Remove(i);
+    }
+  }
+
+  // every search finds what a walk over the buckets one by one does
+  auto walk = [&](slot_offset_t begin, slot_offset_t end, auto &&match) {
+    while (begin < end && !match(begin)) {
+      begin++;
+    }
+    return begin;
+  };
+  for (slot_offset_t begin = 0; begin <= num_slots; begin += 7) {
+    for (slot_offset_t end = begin; end <= num_slots; end += 13) {
+      const uint64_t bits = block_page->ReadableBits(begin, end);
+      for (slot_offset_t i = 0; i < 64; i++) {
+        EXPECT_EQ(begin + i < end && block_page->IsReadable(begin + i), (bits >> (63 - i) & 1) == 1);
+      }
+      EXPECT_EQ(walk(begin, end, [&](slot_offset_t i) { return !block_page->IsReadable(i); }),
+                block_page->NextFree(begin, end));
+      EXPECT_EQ(walk(begin, end, [&](slot_offset_t i) { return !block_page->IsOccupied(i); }),
+                block_page->NextUnoccupied(begin, end));
+      auto is_tombstone = [&](slot_offset_t i) { return block_page->IsOccupied(i) && !block_page->IsReadable(i); };
+      EXPECT_EQ(walk(begin, end, is_tombstone), block_page->NextTombstone(begin, end));
+    }
+  }
+
+  bpm->UnpinPage(block_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BlockPageFingerprintTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  auto block_page =
+      reinterpret_cast<HashTableBlockPage<int, int, IntComparator> *>(bpm->NewPage(&block_page_id, nullptr)->GetData());
+  const slot_offset_t num_slots = HashTableBlockPage<int, int, IntComparator>::FINGERPRINT_ARRAY_SIZE;
+  EXPECT_LT(num_slots, 4 * PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1));
+
+  // a few fingerprints, so that every one of them is in most words
+  std::mt19937 generator(15445);
+  std::vector<uint8_t> fingerprints(num_slots);
+  for (slot_offset_t i = 0; i < num_slots; i++) {
+    fingerprints[i] = generator() % 4;
+    block_page->Insert(i, i, i);
+    block_page->SetFingerprint(i, fingerprints[i]);
+  }
+  for (slot_offset_t i = 0; i < num_slots; i++) {
+    EXPECT_EQ(i, block_page->KeyAt(i));
+  }
+
+  for (slot_offset_t begin = 0; begin <= num_slots; begin += 5) {
+    for (slot_offset_t end = begin; end <= num_slots; end += 11) {
+      const uint8_t fingerprint = (begin + end) % 4;
+      const uint64_t bits = block_page->FingerprintBits(begin, end, fingerprint);
+      for (slot_offset_t i = 0; i < 64; i++) {
+        EXPECT_EQ(begin + i < end && fingerprints[begin + i] == fingerprint, (bits >> (63 - i) & 1) == 1);
+      }
+    }
+  }
+
+  bpm->UnpinPage(block_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Walks probe sequences on a block page filled by linear probing, bucket by bucket and with the bitmap searches.
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DISABLED_ProbeBenchmark) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  const slot_offset_t num_slots = 4 * PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1);
+  const int num_probes = 2000000;
+
+  for (double load_factor : {0.5, 0.75, 0.9, 0.95}) {
+    page_id_t block_page_id = INVALID_PAGE_ID;
+    auto block_page = reinterpret_cast<HashTableBlockPage<int, int, IntComparator> *>(
+        bpm->NewPage(&block_page_id, nullptr)->GetData());
+    // Fill the page the way the table does, wrapping around, and remove a tenth of the pairs.
+    std::mt19937 generator(15445);
+    const auto num_pairs = static_cast<slot_offset_t>(load_factor * num_slots);
+    for (slot_offset_t i = 0; i < num_pairs; i++) {
+      slot_offset_t slot = generator() % num_slots;
+      while (!block_page->Insert(slot, i, i)) {
+        slot = (slot + 1) % num_slots;
+      }
+      if (i % 10 == 0) {
+        block_page->Remove(slot);
+      }
+    }
+    std::vector<slot_offset_t> starts(num_probes);
+    for (auto &start : starts) {
+      start = generator() % num_slots;
+    }
+
+    // Both sum up the keys of the readable buckets up to the end of the sequence, or of the page.
+    auto start_time = std::chrono::steady_clock::now();
+    int64_t slot_sum = 0;
+    for (slot_offset_t start : starts) {
+      for (slot_offset_t slot = start; slot < num_slots && block_page->IsOccupied(slot); slot++) {
+        if (block_page->IsReadable(slot)) {
+          slot_sum += block_page->KeyAt(slot);
+        }
+      }
+    }
+    const double slot_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    start_time = std::chrono::steady_clock::now();
+    int64_t word_sum = 0;
+    for (slot_offset_t start : starts) {
+      const slot_offset_t end = block_page->NextUnoccupied(start, num_slots);
+      for (slot_offset_t base = start; base < end; base += 64) {
+        for (uint64_t bits = block_page->ReadableBits(base, end); bits != 0; bits &= bits - 1) {
+          word_sum += block_page->KeyAt(base + 63 - __builtin_ctzll(bits));
+        }
+      }
+    }
+    const double word_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    EXPECT_EQ(slot_sum, word_sum);
+
+    std::cout << "load factor " << load_factor << ": " << num_probes / slot_seconds << " probes/s bucket by bucket, "
+              << num_probes / word_seconds << " probes/s with bitmap words" << std::endl;
+    bpm->UnpinPage(block_page_id, false, nullptr);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
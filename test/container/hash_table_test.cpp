@@ -10,9 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "catalog/schema.h"
 #include "common/logger.h"
 #include "container/hash/linear_probe_hash_table.h"
 #include "gtest/gtest.h"
@@ -20,6 +28,41 @@
 
 namespace bustub {
 
+namespace {
+// Draws the numbers 0 to n - 1 with a Zipfian distribution, the most popular first, as in YCSB.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+    double zeta2 = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      zeta_n_ += 1 / std::pow(static_cast<double>(i), theta);
+      zeta2 += i <= 2 ? 1 / std::pow(static_cast<double>(i), theta) : 0;
+    }
+    alpha_ = 1 / (1 - theta);
+    eta_ = (1 - std::pow(2.0 / static_cast<double>(n), 1 - theta)) / (1 - zeta2 / zeta_n_);
+  }
+
+  uint64_t Next(std::mt19937_64 *gen) {
+    const double u = std::uniform_real_distribution<double>(0, 1)(*gen);
+    const double uz = u * zeta_n_;
+    if (uz < 1) {
+      return 0;
+    }
+    if (uz < 1 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    return std::min(n_ - 1, static_cast<uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1, alpha_)));
+  }
+
+ private:
+  uint64_t n_;
+  double theta_;
+  double zeta_n_{0};
+  double alpha_;
+  double eta_;
+};
+}  // namespace
+
 // NOLINTNEXTLINE
 TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
@@ -104,4 +147,554 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, ResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  const int num_keys = 1500;
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2000, HashFunction<int>());
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  ht.Resize(2000);
+  EXPECT_EQ(4000, ht.GetSize());
+  EXPECT_TRUE(ht.IsResizing());
+
+  // While the pairs are moved, every one is found in exactly one of the arrays.
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+    if (i % 2 == 0) {
+      // duplicate values for the same key are not allowed, wherever the pair is
+      EXPECT_FALSE(ht.Insert(nullptr, i, i));
+      EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+    } else {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    }
+  }
+  // The writes moved all the pairs.
+  EXPECT_FALSE(ht.IsResizing());
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i % 2 == 0) {
+      ASSERT_EQ(2, res.size());
+      std::sort(res.begin(), res.end());
+      EXPECT_EQ(-i - 1, res[0]);
+      EXPECT_EQ(i, res[1]);
+    } else {
+      EXPECT_EQ(0, res.size());
+    }
+  }
+
+  // A resize that is under way is finished by the next one.
+  ht.Resize(4000);
+  EXPECT_TRUE(ht.IsResizing());
+  ht.Resize(8000);
+  EXPECT_EQ(16000, ht.GetSize());
+  for (int i = 0; i < num_keys; i += 2) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(2, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  const int num_keys = 1000;
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+  auto within_load_factor = [&ht]() {
+    return static_cast<double>(ht.GetNumPairs() + ht.GetNumTombstones()) <=
+           LinearProbeHashTable<int, int, IntComparator>::DEFAULT_MAX_LOAD_FACTOR * static_cast<double>(ht.GetSize());
+  };
+  // A resize leaves room within the maximum load factor for the inserts while it moves the pairs.
+  bool resizing = false;
+  auto resized_with_room = [&ht, &resizing]() {
+    const bool started = !resizing && ht.IsResizing();
+    resizing = ht.IsResizing();
+    const size_t headroom = ht.GetSize() / LinearProbeHashTable<int, int, IntComparator>::MOVED_BUCKETS_PER_WRITE;
+    return !started || static_cast<double>(ht.GetNumPairs() + headroom) <=
+                           LinearProbeHashTable<int, int, IntComparator>::DEFAULT_MAX_LOAD_FACTOR *
+                               static_cast<double>(ht.GetSize());
+  };
+
+  // The table grows by itself.
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    ASSERT_TRUE(within_load_factor()) << "Overloaded after " << i << std::endl;
+    ASSERT_TRUE(resized_with_room()) << "No room for inserts after " << i << std::endl;
+  }
+  EXPECT_EQ(num_keys, ht.GetNumPairs());
+  EXPECT_EQ(0, ht.GetNumTombstones());
+  EXPECT_EQ(1600, ht.GetSize());
+
+  // Replacing all the pairs over and over leaves tombstones behind, the table purges them instead of growing on.
+  for (int round = 1; round <= 20; round++) {
+    for (int i = 0; i < num_keys; i++) {
+      EXPECT_TRUE(ht.Remove(nullptr, (round - 1) * num_keys + i, (round - 1) * num_keys + i));
+      EXPECT_TRUE(ht.Insert(nullptr, round * num_keys + i, round * num_keys + i));
+      ASSERT_TRUE(within_load_factor()) << "Overloaded in round " << round << std::endl;
+      ASSERT_TRUE(resized_with_room()) << "No room for inserts in round " << round << std::endl;
+    }
+  }
+  EXPECT_EQ(num_keys, ht.GetNumPairs());
+  EXPECT_EQ(3200, ht.GetSize());
+  for (int i = 0; i < 21 * num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i >= 20 * num_keys ? 1 : 0, res.size());
+  }
+
+  // With a maximum load factor of 1, the table grows once it is full.
+  LinearProbeHashTable<int, int, IntComparator> full("full", bpm, IntComparator(), 10, HashFunction<int>(), 1);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(full.Insert(nullptr, i, i));
+  }
+  EXPECT_EQ(160, full.GetSize());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ReopenTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  const int num_keys = 1000;
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys / 10; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  const size_t num_tombstones = ht.GetNumTombstones();
+  ASSERT_FALSE(ht.IsResizing());
+
+  // Until they are flushed, the header page has the counts as of the last resize step.
+  LinearProbeHashTable<int, int, IntComparator> stale(bpm, IntComparator(), ht.GetHeaderPageId(), HashFunction<int>());
+  EXPECT_GE(stale.GetNumPairs(), 0.75 * 800);
+  EXPECT_LT(stale.GetNumPairs(), num_keys);
+
+  // The table opens again with its counts and its pairs, and goes on growing.
+  ht.FlushCounts();
+  bpm->FlushAllPages();
+  LinearProbeHashTable<int, int, IntComparator> reopened(bpm, IntComparator(), ht.GetHeaderPageId(),
+                                                         HashFunction<int>());
+  EXPECT_EQ(num_keys - num_keys / 10, reopened.GetNumPairs());
+  EXPECT_EQ(num_tombstones, reopened.GetNumTombstones());
+  EXPECT_EQ(1600, reopened.GetSize());
+  for (int i = num_keys; i < 2 * num_keys; i++) {
+    EXPECT_TRUE(reopened.Insert(nullptr, i, i));
+  }
+  EXPECT_EQ(2 * num_keys - num_keys / 10, reopened.GetNumPairs());
+  EXPECT_EQ(3200, reopened.GetSize());
+  for (int i = 0; i < 2 * num_keys; i++) {
+    std::vector<int> res;
+    reopened.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i < num_keys / 10 ? 0 : 1, res.size());
+  }
+
+  // A resize that was under way is finished when the table opens again.
+  reopened.Resize(2 * num_keys);
+  ASSERT_TRUE(reopened.IsResizing());
+  reopened.FlushCounts();
+  LinearProbeHashTable<int, int, IntComparator> resized(bpm, IntComparator(), reopened.GetHeaderPageId(),
+                                                        HashFunction<int>());
+  EXPECT_FALSE(resized.IsResizing());
+  EXPECT_EQ(4 * num_keys, resized.GetSize());
+  EXPECT_EQ(2 * num_keys - num_keys / 10, resized.GetNumPairs());
+  for (int i = 0; i < 2 * num_keys; i++) {
+    std::vector<int> res;
+    resized.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i < num_keys / 10 ? 0 : 1, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, FingerprintTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  const int num_keys = 5000;
+
+  using HashTableType = LinearProbeHashTable<int, int, IntComparator>;
+  HashTableType ht("blah", bpm, IntComparator(), 10, HashFunction<int>(), HashTableType::DEFAULT_MAX_LOAD_FACTOR, true);
+  // Two values for every key, they share the fingerprint.
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, num_keys + i));
+    EXPECT_FALSE(ht.Insert(nullptr, i, num_keys + i));
+  }
+  EXPECT_EQ(2 * num_keys, ht.GetNumPairs());
+  for (int i = 0; i < 2 * num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ((i < num_keys ? std::vector<int>{i, num_keys + i} : std::vector<int>{}), res);
+  }
+
+  // Remove the first value of the even keys, and insert another one, into the tombstones.
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * num_keys + i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ((std::vector<int>{i % 2 == 0 ? num_keys + i : i, i % 2 == 0 ? 2 * num_keys + i : num_keys + i}), res);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(200, disk_manager);
+  const int num_keys = 20000;
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+  std::atomic<int> num_inserted{0};
+  std::thread writer([&]() {
+    for (int i = 0; i < num_keys; i++) {
+      if (2 * static_cast<size_t>(i) >= ht.GetSize()) {
+        ht.Resize(ht.GetSize());
+      }
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+      num_inserted = i + 1;
+    }
+  });
+
+  // Every pair that has been inserted is found while the table grows.
+  std::thread reader([&]() {
+    for (int i = 0; num_inserted < num_keys; i = (i + 7919) % num_keys) {
+      const int key = i % std::max(num_inserted.load(), 1);
+      std::vector<int> res;
+      if (num_inserted > key) {
+        ht.GetValue(nullptr, key, &res);
+        ASSERT_EQ(1, res.size()) << "Failed to keep " << key << std::endl;
+      }
+    }
+  });
+  writer.join();
+  reader.join();
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentGrowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(200, disk_manager);
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+
+  // Every thread inserts its own keys and removes every other one, while the table grows and purges tombstones.
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = 0; i < keys_per_thread; i++) {
+        const int key = i * num_threads + tid;
+        ASSERT_TRUE(ht.Insert(nullptr, key, key));
+        std::vector<int> res;
+        ht.GetValue(nullptr, key, &res);
+        ASSERT_EQ(1, res.size()) << "Failed to insert " << key << std::endl;
+        if (i % 2 == 1) {
+          ASSERT_TRUE(ht.Remove(nullptr, key - num_threads, key - num_threads));
+          res.clear();
+          ht.GetValue(nullptr, key - num_threads, &res);
+          ASSERT_EQ(0, res.size()) << "Failed to remove " << key - num_threads << std::endl;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(num_threads * keys_per_thread / 2, ht.GetNumPairs());
+  for (int key = 0; key < num_threads * keys_per_thread; key++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    EXPECT_EQ(key / num_threads % 2, res.size()) << key;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, InsertWhileMovingTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  const int num_buckets = 1000;
+  const int num_keys = 700;
+
+  // The block pages of the table are the pages allocated after this one.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  bpm->UnpinPage(page_id, false);
+  const page_id_t first_block_page_id = page_id + 1;
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), num_buckets, HashFunction<int>());
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  ASSERT_EQ(num_buckets, ht.GetSize());
+
+  // Start moving the pairs into as many buckets, like a purge does. Then hold the first old block page, so that the
+  // resize that finishes the move waits for it, with the resize latch held.
+  ht.Resize(num_buckets / 2);
+  ASSERT_TRUE(ht.IsResizing());
+  Page *first_block_page = bpm->FetchPage(first_block_page_id);
+  ASSERT_NE(nullptr, first_block_page);
+  first_block_page->WLatch();
+  std::thread resizer([&ht]() { ht.Resize(num_buckets / 2); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Scenario: inserts go on meanwhile, more than the new buckets can hold next to the pairs still to be moved. They
+  // wait for the resize once the new buckets reach the maximum load factor, so the move never finds them full. Their
+  // keys are in the middle of the old buckets, a probe of the old buckets for them does not reach the held page.
+  std::vector<int> keys;
+  for (int key = num_keys; keys.size() < num_buckets; key++) {
+    const uint64_t bucket = HashFunction<int>().GetHash(key) % num_buckets;
+    if (bucket >= num_buckets / 2 + 20 && bucket < num_buckets - 60) {
+      keys.emplace_back(key);
+    }
+  }
+  std::thread writer([&ht, &keys]() {
+    for (int key : keys) {
+      ASSERT_TRUE(ht.Insert(nullptr, key, key));
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  first_block_page->WUnlatch();
+  bpm->UnpinPage(first_block_page_id, false);
+  resizer.join();
+  writer.join();
+
+  EXPECT_EQ(num_keys + num_buckets, ht.GetNumPairs());
+  for (int i = 0; i < num_keys; i++) {
+    keys.emplace_back(i);
+  }
+  for (int key : keys) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    EXPECT_EQ(1, res.size()) << "Failed to keep " << key << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Measures the latency of GetValue while another thread inserts keys and grows the table whenever it is half full,
+// from 1000 buckets to 256K. Lookups are issued on a fixed schedule and their latency counts from when they were
+// due, so a lookup that waits for a resize also delays the ones behind it. The writer yields after every insert, to
+// leave a single core to the lookups as much as the table lets it.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_GrowthLatencyBenchmark) {
+  const int num_keys = 120000;
+  const auto interval = std::chrono::microseconds(10);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(1024, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  std::atomic<int> num_inserted{1};
+  ht.Insert(nullptr, 0, 0);
+  auto start = std::chrono::steady_clock::now();
+  std::thread writer([&]() {
+    for (int i = 1; i < num_keys; i++) {
+      if (2 * static_cast<size_t>(i) >= ht.GetSize()) {
+        ht.Resize(ht.GetSize());
+      }
+      ht.Insert(nullptr, i, i);
+      num_inserted = i + 1;
+      std::this_thread::yield();
+    }
+  });
+
+  std::vector<double> latencies;
+  std::mt19937 gen(15445);
+  auto due = std::chrono::steady_clock::now();
+  while (num_inserted < num_keys) {
+    if (std::chrono::steady_clock::now() < due) {
+      std::this_thread::yield();
+      continue;
+    }
+    const int key = std::uniform_int_distribution<int>(0, num_inserted - 1)(gen);
+    std::vector<int> result;
+    ht.GetValue(nullptr, key, &result);
+    latencies.emplace_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - due).count());
+    ASSERT_EQ(1, result.size());
+    due += interval;
+  }
+  writer.join();
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+  std::cout << num_keys << " inserts in " << seconds << " s, " << latencies.size() << " lookups, GetValue us p50 "
+            << percentile(0.5) << ", p99 " << percentile(0.99) << ", p99.9 " << percentile(0.999) << ", max "
+            << latencies.back() << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete bpm;
+  delete disk_manager;
+}
+
+// YCSB-style workloads on a hash index: A is 50% lookups and 50% updates, B 95% lookups, C only lookups, with
+// Zipfian keys (theta 0.99). An update removes the pair of a key and inserts it again.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_YCSBBenchmark) {
+  const int num_records = 50000;
+  const int ops_per_thread = 200000;
+  const size_t max_threads = std::max(4U, std::thread::hardware_concurrency());
+  Schema key_schema{{Column{"a", TypeId::INTEGER}}};
+  ZipfianGenerator zipfian(num_records, 0.99);
+
+  for (auto [workload, read_ratio] : std::vector<std::pair<std::string, double>>{{"A", 0.5}, {"B", 0.95}, {"C", 1}}) {
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      auto *disk_manager = new DiskManager("test.db");
+      auto *bpm = new BufferPoolManager(1024, disk_manager);
+      LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>> ht(
+          "index", bpm, GenericComparator<8>(&key_schema), 2 * num_records, HashFunction<GenericKey<8>>());
+      GenericKey<8> key;
+      for (int i = 0; i < num_records; i++) {
+        key.SetFromInteger(i);
+        ht.Insert(nullptr, key, RID(i, 0));
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (size_t tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&, tid, read_ratio = read_ratio]() {
+          std::mt19937_64 gen(tid);
+          GenericKey<8> key;
+          std::vector<RID> result;
+          for (int i = 0; i < ops_per_thread; i++) {
+            const auto k = static_cast<int64_t>(zipfian.Next(&gen));
+            key.SetFromInteger(k);
+            if (std::uniform_real_distribution<double>(0, 1)(gen) < read_ratio) {
+              result.clear();
+              ht.GetValue(nullptr, key, &result);
+            } else {
+              ht.Remove(nullptr, key, RID(k, 0));
+              ht.Insert(nullptr, key, RID(k, 0));
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "workload " << workload << ", threads: " << num_threads
+                << ", ops/s: " << static_cast<double>(num_threads * ops_per_thread) / elapsed.count() << std::endl;
+
+      disk_manager->ShutDown();
+      remove("test.db");
+      remove("test.free");
+      delete bpm;
+      delete disk_manager;
+    }
+  }
+}
+
+// Lookups of keys that are in the table and of keys that are not, with and without fingerprints, on tables that are
+// filled up to their maximum load factor. A GenericComparator deserializes the keys it compares.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_FingerprintBenchmark) {
+  const int num_records = 50000;
+  const int num_lookups = 1000000;
+  Schema key_schema{{Column{"a", TypeId::INTEGER}}};
+  using HashTableType = LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+
+  for (double load_factor : {0.5, 0.75, 0.9}) {
+    for (bool fingerprints : {false, true}) {
+      auto *disk_manager = new DiskManager("test.db");
+      auto *bpm = new BufferPoolManager(1024, disk_manager);
+      HashTableType ht("index", bpm, GenericComparator<8>(&key_schema),
+                       static_cast<size_t>(std::ceil(num_records / load_factor)), HashFunction<GenericKey<8>>(),
+                       load_factor, fingerprints);
+      GenericKey<8> key;
+      for (int i = 0; i < num_records; i++) {
+        key.SetFromInteger(i);
+        ht.Insert(nullptr, key, RID(i, 0));
+      }
+
+      std::cout << "load factor " << load_factor << (fingerprints ? ", fingerprints" : ", no fingerprints");
+      for (bool hits : {true, false}) {
+        std::mt19937_64 gen(15445);
+        std::vector<RID> result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_lookups; i++) {
+          const auto k = static_cast<int64_t>(gen() % num_records);
+          key.SetFromInteger(hits ? k : num_records + k);
+          result.clear();
+          ht.GetValue(nullptr, key, &result);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << (hits ? ", hits/s: " : ", misses/s: ") << num_lookups / elapsed.count();
+      }
+      std::cout << std::endl;
+
+      disk_manager->ShutDown();
+      remove("test.db");
+      remove("test.free");
+      delete bpm;
+      delete disk_manager;
+    }
+  }
+}
+
 }  // namespace bustub
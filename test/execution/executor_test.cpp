@@ -122,7 +122,7 @@ class ExecutorTest : public ::testing::Test {
 };
 
 // NOLINTNEXTLINE
-TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
+TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // SELECT colA, colB FROM test_1 WHERE colA < 500
   TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
   Schema &schema = table_info->schema_;
@@ -148,6 +148,43 @@ TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
   ASSERT_EQ(num_tuples, 500);
 }
 
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, SeqScanZoneMapTest) {
+  // SELECT colA FROM test_1 WHERE <colA compared to a constant>, the scan skips pages through the zone map.
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  ASSERT_NE(nullptr, table_info->table_->GetZoneMap());
+  auto *colA = MakeColumnValueExpression(schema, 0, "colA");
+  auto *out_schema = MakeOutputSchema({{"colA", colA}});
+  auto count = [&](const AbstractExpression *lhs, const AbstractExpression *rhs, ComparisonType comp_type) {
+    SeqScanPlanNode plan{out_schema, MakeComparisonExpression(lhs, rhs, comp_type), table_info->oid_};
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &plan);
+    executor->Init();
+    Tuple tuple;
+    uint32_t num_tuples = 0;
+    while (executor->Next(&tuple)) {
+      num_tuples++;
+    }
+    return num_tuples;
+  };
+  auto *const42 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(42));
+  auto *const900 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(900));
+  auto *const5000 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(5000));
+
+  // colA is 0..999 in order, the results are the same as without skipping.
+  EXPECT_EQ(1, count(colA, const42, ComparisonType::Equal));
+  EXPECT_EQ(999, count(colA, const42, ComparisonType::NotEqual));
+  EXPECT_EQ(42, count(colA, const42, ComparisonType::LessThan));
+  EXPECT_EQ(43, count(colA, const42, ComparisonType::LessThanOrEqual));
+  EXPECT_EQ(99, count(colA, const900, ComparisonType::GreaterThan));
+  EXPECT_EQ(100, count(colA, const900, ComparisonType::GreaterThanOrEqual));
+  // The constant on the left turns the comparison around.
+  EXPECT_EQ(99, count(const900, colA, ComparisonType::LessThan));
+  EXPECT_EQ(900, count(const900, colA, ComparisonType::GreaterThan));
+  EXPECT_EQ(0, count(colA, const5000, ComparisonType::GreaterThanOrEqual));
+  EXPECT_EQ(1000, count(const5000, colA, ComparisonType::GreaterThan));
+}
+
 // NOLINTNEXTLINE
 TEST_F(ExecutorTest, DISABLED_SimpleRawInsertTest) {
   // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
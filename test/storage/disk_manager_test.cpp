@@ -0,0 +1,325 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_test.cpp
+//
+// Identification: test/storage/disk_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ReadWritePageTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Scenario: reading a page that was never written yields zeros.
+  std::memset(buf, 'x', sizeof(buf));
+  dm->ReadPage(0, buf);
+  for (char c : buf) {
+    ASSERT_EQ(0, c);
+  }
+
+  // Scenario: pages can be written in any order and read back.
+  dm->WritePage(5, data);
+  dm->WritePage(0, data);
+  dm->ReadPage(5, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  EXPECT_EQ(6, dm->GetNumPages());
+  EXPECT_EQ(2, dm->GetNumWrites());
+
+  // Scenario: writes are only synced at explicit sync points, and survive a restart.
+  EXPECT_EQ(0, dm->GetNumSyncs());
+  dm->SyncData();
+  EXPECT_EQ(1, dm->GetNumSyncs());
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  dm->ReadPage(5, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  auto *dm = new DiskManager("test.db");
+
+  // Scenario: threads writing and reading their own pages at the same time never see each other's data.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([dm, tid]() {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + tid;
+          std::memset(data, 'a' + tid, sizeof(data));
+          snprintf(data, sizeof(data), "%d %d", page_id, round);
+          dm->WritePage(page_id, data);
+          dm->ReadPage(page_id, buf);
+          EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm->GetNumReads());
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, AsyncReadWriteTest) {
+  const int num_pages = 512;
+  // Run once with io_uring, if the kernel allows it, and once with the thread pool fallback.
+  for (bool use_io_uring : {true, false}) {
+    auto *dm = new DiskManager("test.db", use_io_uring);
+    if (!use_io_uring) {
+      EXPECT_FALSE(dm->UsesIOUring());
+    }
+
+    // Scenario: many writes in flight at once, more than the queue depth, all land.
+    std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+    std::vector<std::future<void>> futures;
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memset(data[page_id].data(), 'a' + page_id % 26, PAGE_SIZE);
+      snprintf(data[page_id].data(), PAGE_SIZE, "%d", page_id);
+      futures.emplace_back(dm->WritePageAsync(page_id, data[page_id].data()));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+    futures.clear();
+
+    // Scenario: reads in flight at once return the right pages, reads past the end return zeros.
+    std::vector<std::vector<char>> buf(num_pages + 1, std::vector<char>(PAGE_SIZE, 'x'));
+    for (page_id_t page_id = num_pages; page_id >= 0; page_id--) {
+      futures.emplace_back(dm->ReadPageAsync(page_id, buf[page_id].data()));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      EXPECT_EQ(data[page_id], buf[page_id]);
+    }
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), buf[num_pages]);
+    EXPECT_EQ(num_pages, dm->GetNumWrites());
+    EXPECT_EQ(num_pages + 1, dm->GetNumReads());
+
+    // Scenario: the synchronous path sees what the asynchronous one wrote.
+    char page[PAGE_SIZE];
+    dm->ReadPage(7, page);
+    EXPECT_EQ(0, std::memcmp(page, data[7].data(), PAGE_SIZE));
+
+    dm->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    delete dm;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, DirectIOTest) {
+  // Not every file system supports O_DIRECT, the disk manager falls back to buffered I/O there.
+  auto *dm = new DiskManager("test.db", true, true);
+  std::cout << "direct I/O: " << dm->UsesDirectIO() << std::endl;
+
+  // Scenario: aligned and unaligned buffers both work, synchronously and asynchronously.
+  auto *aligned = static_cast<char *>(std::aligned_alloc(4096, PAGE_SIZE));
+  std::vector<char> unaligned_storage(PAGE_SIZE + 1);
+  char *unaligned = unaligned_storage.data() + 1;
+  std::memset(aligned, 'a', PAGE_SIZE);
+  std::memset(unaligned, 'u', PAGE_SIZE);
+  dm->WritePage(0, aligned);
+  dm->WritePage(1, unaligned);
+  dm->WritePageAsync(2, aligned).wait();
+  dm->WritePageAsync(3, unaligned).wait();
+
+  std::vector<char> expected_a(PAGE_SIZE, 'a');
+  std::vector<char> expected_u(PAGE_SIZE, 'u');
+  for (page_id_t page_id = 0; page_id < 4; page_id++) {
+    const auto &expected = page_id % 2 == 0 ? expected_a : expected_u;
+    std::memset(aligned, 0, PAGE_SIZE);
+    dm->ReadPage(page_id, aligned);
+    EXPECT_EQ(0, std::memcmp(aligned, expected.data(), PAGE_SIZE));
+    std::memset(unaligned, 0, PAGE_SIZE);
+    dm->ReadPageAsync(page_id, unaligned).wait();
+    EXPECT_EQ(0, std::memcmp(unaligned, expected.data(), PAGE_SIZE));
+  }
+  EXPECT_EQ(4, dm->GetNumPages());
+
+  std::free(aligned);
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, PageReuseTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  remove("test.free");
+  auto *dm = new DiskManager(db_file);
+
+  // Scenario: allocate and write 16 pages.
+  for (page_id_t i = 0; i < 16; i++) {
+    EXPECT_EQ(i, dm->AllocatePage());
+    dm->WritePage(i, data);
+  }
+  EXPECT_EQ(16, dm->GetNumPages());
+
+  // Scenario: deallocated pages are handed out again, lowest first, and the file does not grow.
+  dm->DeallocatePage(9);
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(3);
+  EXPECT_EQ(2, dm->GetNumFreePages());
+  EXPECT_TRUE(dm->IsPageFree(3));
+  EXPECT_FALSE(dm->IsPageFree(4));
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(9, dm->AllocatePage());
+  EXPECT_EQ(16, dm->AllocatePage());
+  EXPECT_EQ(0, dm->GetNumFreePages());
+  dm->WritePage(16, data);
+  EXPECT_EQ(17, dm->GetNumPages());
+
+  // Scenario: freeing the last pages of the file shrinks it.
+  dm->DeallocatePage(12);
+  dm->DeallocatePage(16);
+  dm->DeallocatePage(15);
+  dm->DeallocatePage(14);
+  dm->DeallocatePage(13);
+  EXPECT_EQ(12, dm->GetNumPages());
+  EXPECT_EQ(0, dm->GetNumFreePages());
+  EXPECT_EQ(12, dm->AllocatePage());
+
+  // Scenario: the free page map survives a restart.
+  dm->DeallocatePage(5);
+  dm->DeallocatePage(7);
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  EXPECT_EQ(2, dm->GetNumFreePages());
+  EXPECT_EQ(5, dm->AllocatePage());
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(12, dm->AllocatePage());
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.free");
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, BoundedFileSizeTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  remove("test.free");
+  auto *dm = new DiskManager(db_file);
+  std::mt19937 gen(15445);
+
+  // Scenario: a working set of 64 pages under allocate/deallocate churn never needs more than 64 pages of file.
+  std::vector<page_id_t> live;
+  for (int round = 0; round < 10000; round++) {
+    if (live.size() < 64 && (live.empty() || gen() % 2 == 0)) {
+      page_id_t page_id = dm->AllocatePage();
+      dm->WritePage(page_id, data);
+      live.emplace_back(page_id);
+    } else {
+      auto victim = live.begin() + gen() % live.size();
+      dm->DeallocatePage(*victim);
+      live.erase(victim);
+    }
+    ASSERT_LE(dm->GetNumPages(), 64);
+  }
+  // Every live page is still allocated.
+  for (auto page_id : live) {
+    EXPECT_FALSE(dm->IsPageFree(page_id));
+  }
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.free");
+  delete dm;
+}
+
+// Measures random page reads per second with a growing number of threads. Unless the file is evicted from the OS
+// page cache in between, this mostly measures the syscall path rather than the device.
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, DISABLED_RandomReadIOPSBenchmark) {
+  const int num_pages = 16384;
+  const int reads_per_thread = 100000;
+  const size_t max_threads = std::max(2U, std::thread::hardware_concurrency());
+  auto *dm = new DiskManager("test.db");
+  char data[PAGE_SIZE] = {0};
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    snprintf(data, sizeof(data), "%d", page_id);
+    dm->WritePage(page_id, data);
+  }
+  dm->SyncData();
+
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([dm, tid]() {
+        char buf[PAGE_SIZE];
+        std::mt19937 gen(tid);
+        std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+        for (int i = 0; i < reads_per_thread; i++) {
+          dm->ReadPage(dist(gen), buf);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "threads: " << num_threads
+              << ", random reads/s: " << static_cast<double>(num_threads * reads_per_thread) / elapsed.count()
+              << std::endl;
+  }
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete dm;
+}
+
+}  // namespace bustub
@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_size_test.cpp
+//
+// Identification: test/storage/page_size_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/free_space_map_page.h"
+#include "storage/page/hash_table_block_page.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// bytes a hash table block page uses: the bitmaps and the array of mappings after them
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t BlockPageSize() {
+  return sizeof(HASH_TABLE_BLOCK_TYPE) + BLOCK_ARRAY_SIZE * sizeof(MappingType);
+}
+
+// The page layouts follow PAGE_SIZE, see BUSTUB_PAGE_SIZE in CMakeLists.txt. This runs with whatever page size the
+// tests were built with.
+// NOLINTNEXTLINE
+TEST(PageSizeTest, LayoutTest) {
+  // The block pages of the hash tables fill the page.
+  EXPECT_LE((BlockPageSize<int, int, IntComparator>()), PAGE_SIZE);
+  EXPECT_GT((BlockPageSize<int, int, IntComparator>()), PAGE_SIZE - 8 - 1);
+  EXPECT_LE((BlockPageSize<GenericKey<64>, RID, GenericComparator<64>>()), PAGE_SIZE);
+  EXPECT_GT((BlockPageSize<GenericKey<64>, RID, GenericComparator<64>>()), PAGE_SIZE - 72 - 1);
+  EXPECT_LE(sizeof(FreeSpaceMapPage), PAGE_SIZE);
+  EXPECT_GT(2 * sizeof(FreeSpaceMapPage), PAGE_SIZE);
+  EXPECT_EQ(PAGE_SIZE, sizeof(OverflowPage));
+
+  // A table page takes as many tuples as fit into the page.
+  Column col{"a", TypeId::INTEGER};
+  Schema schema{{col}};
+  Tuple tuple({ValueFactory::GetIntegerValue(1)}, &schema);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  auto *txn = new Transaction(0);
+  page_id_t page_id;
+  auto *page = static_cast<TablePage *>(bpm->NewPage(&page_id));
+  ASSERT_NE(nullptr, page);
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, txn);
+  size_t count = 0;
+  RID rid;
+  while (page->InsertTuple(tuple, &rid, txn, nullptr, nullptr)) {
+    count++;
+  }
+  EXPECT_EQ((PAGE_SIZE - TablePage::SIZE_TABLE_PAGE_HEADER) / (tuple.GetLength() + TablePage::SIZE_TUPLE), count);
+  bpm->UnpinPage(page_id, true);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures a cold scan and random lookups through a hash index with the page size of this build, with the same
+// amount of buffer pool memory for every page size. Build with -DBUSTUB_PAGE_SIZE=... to compare.
+// NOLINTNEXTLINE
+TEST(PageSizeTest, DISABLED_ScanAndLookupBenchmark) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 64};
+  Schema schema{{col1, col2}};
+  // The hash table header page holds the block pages for about 250K buckets with 4 KiB pages.
+  const int num_tuples = 100000;
+  const int num_lookups = 200000;
+  // Less than the table and the index take together.
+  const size_t pool_bytes = 4 << 20;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  page_id_t first_page_id;
+  std::vector<RID> rids;
+  {
+    auto *bpm = new BufferPoolManager(pool_bytes / PAGE_SIZE, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    std::vector<Tuple> tuples;
+    for (int i = 0; i < num_tuples; i++) {
+      tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i),
+                                             ValueFactory::GetVarcharValue(std::string(32, 'a' + i % 26))},
+                          &schema);
+      if (tuples.size() == 1024 || i + 1 == num_tuples) {
+        ASSERT_TRUE(table.BulkInsert(tuples, &rids, txn));
+        tuples.clear();
+      }
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  // Cold scan.
+  auto *bpm = new BufferPoolManager(pool_bytes / PAGE_SIZE, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+  int num_reads = disk_manager->GetNumReads();
+  auto start = std::chrono::steady_clock::now();
+  int count = 0;
+  for (auto iter = table.Begin(txn, nullptr, 0, true); iter != table.End(); ++iter) {
+    count += iter->GetValue(&schema, 0).GetAs<int32_t>() % 2;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_tuples / 2, count);
+  std::cout << "page size " << PAGE_SIZE << ": scan " << static_cast<int>(num_tuples / seconds) << " rows/s, "
+            << disk_manager->GetNumReads() - num_reads << " page reads" << std::endl;
+
+  // Random lookups through a hash index on the first column.
+  Schema key_schema{{col1}};
+  LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>> index(
+      "index", bpm, GenericComparator<8>(&key_schema), 2 * num_tuples, HashFunction<GenericKey<8>>());
+  GenericKey<8> key;
+  for (int i = 0; i < num_tuples; i++) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(index.Insert(txn, key, rids[i]));
+  }
+  num_reads = disk_manager->GetNumReads();
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int> dist(0, num_tuples - 1);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_lookups; i++) {
+    int k = dist(gen);
+    key.SetFromInteger(k);
+    std::vector<RID> result;
+    index.GetValue(txn, key, &result);
+    ASSERT_EQ(1, result.size());
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(result[0], &tuple, txn));
+    ASSERT_EQ(k, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "page size " << PAGE_SIZE << ": " << static_cast<int>(num_lookups / seconds) << " lookups/s, "
+            << disk_manager->GetNumReads() - num_reads << " page reads" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete bpm;
+  delete txn;
+  delete disk_manager;
+}
+
+}  // namespace bustub
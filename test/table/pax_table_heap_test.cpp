@@ -0,0 +1,402 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_heap_test.cpp
+//
+// Identification: test/table/pax_table_heap_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/table/pax_table_heap.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PaxTableHeapTest, LayoutTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::BIGINT};
+  Column col3{"c", TypeId::BOOLEAN};
+  Schema schema{{col1, col2, col3}};
+  PaxLayout layout(schema);
+
+  // The minipages follow each other, the last one ends within the page and one more tuple would not fit.
+  const uint32_t capacity = layout.GetCapacity();
+  EXPECT_EQ(13, layout.GetTupleLength());
+  EXPECT_GE(layout.GetMinipageOffset(0), PaxPage::SIZE_PAX_PAGE_HEADER + (capacity + 7) / 8);
+  EXPECT_EQ(0, layout.GetMinipageOffset(0) % 8);
+  EXPECT_EQ(layout.GetMinipageOffset(0) + 4 * capacity, layout.GetMinipageOffset(1));
+  EXPECT_EQ(layout.GetMinipageOffset(1) + 8 * capacity, layout.GetMinipageOffset(2));
+  EXPECT_LE(layout.GetMinipageOffset(2) + capacity, PAGE_SIZE);
+  EXPECT_GT(PaxPage::SIZE_PAX_PAGE_HEADER + (capacity + 1 + 7) / 8 + (capacity + 1) * 13, PAGE_SIZE);
+}
+
+// NOLINTNEXTLINE
+TEST(PaxTableHeapTest, InsertDeleteScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::BIGINT};
+  Column col3{"c", TypeId::SMALLINT};
+  Schema schema{{col1, col2, col3}};
+  auto make_tuple = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetBigIntValue(int64_t{i} * 1000),
+                  ValueFactory::GetSmallIntValue(static_cast<int16_t>(i % 100))},
+                 &schema);
+  };
+  const int num_tuples = 3 * PaxLayout(schema).GetCapacity() + 10;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t first_page_id;
+  std::vector<RID> rids(num_tuples);
+  {
+    PaxTableHeap table(bpm, schema);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(table.InsertTuple(make_tuple(i), &rids[i]));
+    }
+    // Delete every third tuple.
+    for (int i = 0; i < num_tuples; i += 3) {
+      ASSERT_TRUE(table.DeleteTuple(rids[i]));
+      ASSERT_FALSE(table.DeleteTuple(rids[i]));
+    }
+    Tuple tuple;
+    EXPECT_FALSE(table.GetTuple(rids[0], &tuple));
+    ASSERT_TRUE(table.GetTuple(rids[1], &tuple));
+    EXPECT_EQ(1, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(1000, tuple.GetValue(&schema, 1).GetAs<int64_t>());
+    EXPECT_EQ(1, tuple.GetValue(&schema, 2).GetAs<int16_t>());
+    EXPECT_EQ(rids[1], tuple.GetRid());
+  }
+  bpm->FlushAllPages();
+
+  // Reopen the table and scan two of the columns, in the other order.
+  PaxTableHeap table(bpm, schema, first_page_id);
+  int count = 0;
+  int expected = 1;
+  auto iter = table.Begin({2, 1});
+  ASSERT_EQ(2, iter.GetSchema()->GetColumnCount());
+  ASSERT_EQ(10, iter->GetLength());
+  for (; iter != table.End(); ++iter) {
+    EXPECT_EQ(rids[expected], iter->GetRid());
+    EXPECT_EQ(expected % 100, iter->GetValue(iter.GetSchema(), 0).GetAs<int16_t>());
+    EXPECT_EQ(int64_t{expected} * 1000, iter->GetValue(iter.GetSchema(), 1).GetAs<int64_t>());
+    count++;
+    expected += expected % 3 == 1 ? 1 : 2;
+  }
+  EXPECT_EQ(num_tuples - (num_tuples + 2) / 3, count);
+
+  // Inserts go to the last page, and reuse its deleted slots once it is full.
+  RID rid;
+  int last = num_tuples - 1;
+  while (rids[last].GetPageId() == rids[num_tuples - 1].GetPageId()) {
+    last--;
+  }
+  int deleted_on_last_page = 0;
+  for (int i = last + 1; i < num_tuples; i++) {
+    deleted_on_last_page += i % 3 == 0 ? 1 : 0;
+  }
+  const uint32_t free_slots = PaxLayout(schema).GetCapacity() - (num_tuples - 1 - last);
+  for (uint32_t i = 0; i < free_slots + deleted_on_last_page; i++) {
+    ASSERT_TRUE(table.InsertTuple(make_tuple(-1), &rid));
+    EXPECT_EQ(rids[num_tuples - 1].GetPageId(), rid.GetPageId());
+  }
+  ASSERT_TRUE(table.InsertTuple(make_tuple(-1), &rid));
+  EXPECT_NE(rids[num_tuples - 1].GetPageId(), rid.GetPageId());
+  EXPECT_EQ(0, rid.GetSlotNum());
+
+  // The full pages were sealed.
+  auto *first_page = static_cast<PaxPage *>(bpm->FetchPage(first_page_id));
+  EXPECT_TRUE(first_page->IsSealed());
+  EXPECT_EQ(PaxEncoding::FRAME_OF_REFERENCE, first_page->GetEncoding(table.GetLayout(), 0));
+  bpm->UnpinPage(first_page_id, false);
+
+  // An empty table.
+  PaxTableHeap empty(bpm, schema);
+  EXPECT_TRUE(empty.Begin({0}) == empty.End());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PaxTableHeapTest, EncodingTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::SMALLINT};
+  Column col5{"e", TypeId::DECIMAL};
+  Schema schema{{col1, col2, col3, col4, col5}};
+  // a is unique, b has few distinct values far apart and nulls, c has long runs, d a narrow range.
+  auto value_a = [](int i) { return int64_t{i}; };
+  auto value_b = [](int i) { return i % 13 == 0 ? int64_t{BUSTUB_INT32_NULL} : int64_t{i % 10} * 1000000; };
+  auto value_c = [](int i) { return int64_t{i / 50}; };
+  auto value_d = [](int i) { return int64_t{i * 37 % 1000}; };
+  const int num_tuples = 20 * PaxLayout(schema).GetCapacity();
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  PaxTableHeap table(bpm, schema);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(
+        std::vector<Value>{ValueFactory::GetIntegerValue(value_a(i)),
+                           i % 13 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                       : ValueFactory::GetIntegerValue(value_b(i)),
+                           ValueFactory::GetBigIntValue(value_c(i)),
+                           ValueFactory::GetSmallIntValue(static_cast<int16_t>(value_d(i))),
+                           ValueFactory::GetDecimalValue(i / 4.0)},
+        &schema);
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(table.BulkInsert(tuples, &rids));
+  ASSERT_EQ(num_tuples, rids.size());
+
+  // The pages hold more tuples than unsealed ones, and every column got its encoding.
+  EXPECT_EQ(table.GetFirstPageId(), rids[0].GetPageId());
+  uint32_t on_first_page = 0;
+  for (const auto &rid : rids) {
+    on_first_page += rid.GetPageId() == rids[0].GetPageId() ? 1 : 0;
+  }
+  EXPECT_GT(on_first_page, PaxLayout(schema).GetCapacity());
+  auto *page = static_cast<PaxPage *>(bpm->FetchPage(rids[0].GetPageId()));
+  EXPECT_TRUE(page->IsSealed());
+  EXPECT_EQ(PaxEncoding::FRAME_OF_REFERENCE, page->GetEncoding(table.GetLayout(), 0));
+  EXPECT_EQ(PaxEncoding::DICTIONARY, page->GetEncoding(table.GetLayout(), 1));
+  EXPECT_EQ(PaxEncoding::RLE, page->GetEncoding(table.GetLayout(), 2));
+  EXPECT_EQ(PaxEncoding::FRAME_OF_REFERENCE, page->GetEncoding(table.GetLayout(), 3));
+  EXPECT_EQ(PaxEncoding::PLAIN, page->GetEncoding(table.GetLayout(), 4));
+  bpm->UnpinPage(rids[0].GetPageId(), false);
+
+  // Every tuple decodes to what was inserted.
+  for (int i = 0; i < num_tuples; i += 7) {
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(rids[i], &tuple));
+    for (uint32_t col = 0; col < schema.GetColumnCount(); col++) {
+      const Value value = tuple.GetValue(&schema, col);
+      const Value expected = tuples[i].GetValue(&schema, col);
+      EXPECT_EQ(expected.IsNull(), value.IsNull());
+      EXPECT_TRUE(expected.IsNull() || value.CompareEquals(expected) == CmpBool::CmpTrue);
+    }
+  }
+
+  // Scans with predicates return the tuples a check of the values finds.
+  std::vector<std::function<int64_t(int)>> values{value_a, value_b, value_c, value_d};
+  auto check = [&](const PaxPredicate &predicate, const std::function<bool(int)> &live) {
+    std::vector<int> expected;
+    for (int i = 0; i < num_tuples; i++) {
+      const int64_t value = values[predicate.column_idx_](i);
+      const bool is_null = predicate.column_idx_ == 1 && value == BUSTUB_INT32_NULL;
+      if (live(i) && !is_null && (predicate.low_ <= value && value <= predicate.high_) != predicate.negate_) {
+        expected.emplace_back(i);
+      }
+    }
+    size_t pos = 0;
+    for (auto iter = table.Begin({0, 4}, &predicate); iter != table.End(); ++iter) {
+      ASSERT_LT(pos, expected.size());
+      EXPECT_EQ(rids[expected[pos]], iter->GetRid());
+      EXPECT_EQ(expected[pos], iter->GetValue(iter.GetSchema(), 0).GetAs<int32_t>());
+      EXPECT_EQ(expected[pos] / 4.0, iter->GetValue(iter.GetSchema(), 1).GetAs<double>());
+      pos++;
+    }
+    EXPECT_EQ(expected.size(), pos);
+  };
+  auto all = [](int i) { return true; };
+  check({0, 100, 2000, false}, all);
+  check({0, 100, 2000, true}, all);
+  check({1, 3000000, 3000000, false}, all);
+  check({1, 3000000, 3000000, true}, all);
+  check({1, BUSTUB_INT64_NULL, 2000000, false}, all);
+  check({2, 20, 40, false}, all);
+  check({2, 30, 30, true}, all);
+  check({3, 500, BUSTUB_INT64_MAX, false}, all);
+  check({3, 10, 5, false}, all);
+
+  // Deleted tuples are not returned.
+  for (int i = 0; i < num_tuples; i += 5) {
+    ASSERT_TRUE(table.DeleteTuple(rids[i]));
+  }
+  auto not_deleted = [](int i) { return i % 5 != 0; };
+  check({1, 3000000, 3000000, false}, not_deleted);
+  check({2, 20, 40, false}, not_deleted);
+
+  // Inserts after a bulk insert go to a new, unsealed page.
+  RID rid;
+  ASSERT_TRUE(table.InsertTuple(tuples[0], &rid));
+  EXPECT_NE(rids.back().GetPageId(), rid.GetPageId());
+  EXPECT_EQ(0, rid.GetSlotNum());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Sums one column of a wide table, through a zero-copy scan of a TableHeap and through a projected scan of the same
+// tuples in a PaxTableHeap. Both tables are in the buffer pool.
+// NOLINTNEXTLINE
+TEST(PaxTableHeapTest, DISABLED_ProjectedScanBenchmark) {
+  const int num_columns = 16;
+  const int num_tuples = 1000000;
+  const int num_scans = 5;
+  std::vector<Column> columns;
+  for (int i = 0; i < num_columns; i++) {
+    columns.emplace_back("c" + std::to_string(i), TypeId::INTEGER);
+  }
+  Schema schema(columns);
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager((size_t{200} << 20) / PAGE_SIZE, disk_manager);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, nullptr, nullptr, txn);
+  PaxTableHeap pax_table(bpm, schema);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    std::vector<Value> values;
+    for (int j = 0; j < num_columns; j++) {
+      values.emplace_back(ValueFactory::GetIntegerValue(i + j));
+    }
+    tuples.emplace_back(values, &schema);
+    RID rid;
+    ASSERT_TRUE(pax_table.InsertTuple(tuples.back(), &rid));
+    if (tuples.size() == 1024 || i + 1 == num_tuples) {
+      ASSERT_TRUE(table.BulkInsert(tuples, nullptr, txn));
+      tuples.clear();
+    }
+  }
+  const int64_t expected = int64_t{num_tuples} * (num_tuples - 1) / 2 + int64_t{num_tuples} * 3;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < num_scans; n++) {
+    int64_t sum = 0;
+    for (auto iter = table.Begin(txn, nullptr, 0, true); iter != table.End(); ++iter) {
+      sum += iter->GetValue(&schema, 3).GetAs<int32_t>();
+    }
+    ASSERT_EQ(expected, sum);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "row scan: " << static_cast<int64_t>(num_scans * num_tuples / seconds) << " rows/s" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int n = 0; n < num_scans; n++) {
+    int64_t sum = 0;
+    auto iter = pax_table.Begin({3});
+    for (; iter != pax_table.End(); ++iter) {
+      sum += iter->GetValue(iter.GetSchema(), 0).GetAs<int32_t>();
+    }
+    ASSERT_EQ(expected, sum);
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "pax projected scan: " << static_cast<int64_t>(num_scans * num_tuples / seconds) << " rows/s"
+            << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// Counts the tuples with b = 3 in a table like test_1 of the executor tests (a unique, b uniform over 0..9), in a
+// TableHeap, in a PaxTableHeap filled by single inserts and in one filled by a bulk insert, and reports the pages
+// each one takes. All the tables are in the buffer pool.
+// NOLINTNEXTLINE
+TEST(PaxTableHeapTest, DISABLED_CompressedScanBenchmark) {
+  const int num_tuples = 1000000;
+  const int num_scans = 5;
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  Schema schema{{col1, col2}};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager((size_t{100} << 20) / PAGE_SIZE, disk_manager);
+  auto *txn = new Transaction(0);
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int> dist(0, 9);
+  std::vector<Tuple> tuples;
+  int expected = 0;
+  for (int i = 0; i < num_tuples; i++) {
+    const int b = dist(gen);
+    expected += b == 3 ? 1 : 0;
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(b)},
+                        &schema);
+  }
+  auto count_pages = [](const std::vector<RID> &rids) {
+    std::set<page_id_t> page_ids;
+    for (const auto &rid : rids) {
+      page_ids.insert(rid.GetPageId());
+    }
+    return page_ids.size();
+  };
+
+  TableHeap table(bpm, nullptr, nullptr, txn);
+  std::vector<RID> rids;
+  ASSERT_TRUE(table.BulkInsert(tuples, &rids, txn));
+  const size_t table_pages = count_pages(rids);
+  PaxTableHeap pax_table(bpm, schema);
+  rids.clear();
+  for (const auto &tuple : tuples) {
+    RID rid;
+    ASSERT_TRUE(pax_table.InsertTuple(tuple, &rid));
+    rids.emplace_back(rid);
+  }
+  const size_t pax_pages = count_pages(rids);
+  PaxTableHeap sealed_table(bpm, schema);
+  rids.clear();
+  ASSERT_TRUE(sealed_table.BulkInsert(tuples, &rids));
+  const size_t sealed_pages = count_pages(rids);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < num_scans; n++) {
+    int count = 0;
+    for (auto iter = table.Begin(txn, nullptr, 0, true); iter != table.End(); ++iter) {
+      count += iter->GetValue(&schema, 1).GetAs<int32_t>() == 3 ? 1 : 0;
+    }
+    ASSERT_EQ(expected, count);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "TableHeap: " << table_pages << " pages, " << static_cast<int64_t>(num_scans * num_tuples / seconds)
+            << " rows/s" << std::endl;
+
+  const PaxPredicate predicate{1, 3, 3, false};
+  for (auto *heap : {&pax_table, &sealed_table}) {
+    start = std::chrono::steady_clock::now();
+    for (int n = 0; n < num_scans; n++) {
+      int count = 0;
+      for (auto iter = heap->Begin({0}, &predicate); iter != heap->End(); ++iter) {
+        count++;
+      }
+      ASSERT_EQ(expected, count);
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (heap == &pax_table ? "PaxTableHeap, inserts: " : "PaxTableHeap, bulk insert: ")
+              << (heap == &pax_table ? pax_pages : sealed_pages) << " pages, "
+              << static_cast<int64_t>(num_scans * num_tuples / seconds) << " rows/s" << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
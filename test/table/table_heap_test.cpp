@@ -0,0 +1,1146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "concurrency/lock_manager.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ScanWithBufferRingTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  // About 45 pages, whatever the page size.
+  const int num_tuples = PAGE_SIZE / 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  page_id_t first_page_id;
+  {
+    // Build a table that is several times larger than the pools below.
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  const size_t buffer_pool_size = 10;
+  const size_t ring_size = 3;
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+
+  // Some hot pages that are not part of the table.
+  std::vector<page_id_t> hot_page_ids;
+  for (int i = 0; i < 5; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    hot_page_ids.emplace_back(page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: a scan through a ring sees every tuple but only ever takes ring_size frames, the hot pages stay.
+  BufferRing ring(ring_size);
+  int count = 0;
+  for (auto iter = table.Begin(txn, &ring); iter != table.End(); ++iter) {
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_GT(ring.GetNumRecycled(), 0);
+  int num_reads = disk_manager->GetNumReads();
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  // Scenario: with readahead, the prefetched pages go into the ring as well, the hot pages still stay.
+  BufferRing readahead_ring(ring_size);
+  count = 0;
+  for (auto iter = table.Begin(txn, &readahead_ring, 8); iter != table.End(); ++iter) {
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_GT(bpm->GetNumPrefetched(), 0);
+  num_reads = disk_manager->GetNumReads();
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  // Scenario: the same scan without a ring pushes the hot pages out of the pool.
+  count = 0;
+  for (auto iter = table.Begin(txn); iter != table.End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  num_reads = disk_manager->GetNumReads();
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_LT(num_reads, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete txn;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ScanWithReadaheadTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  // About 45 pages, whatever the page size.
+  const int num_tuples = PAGE_SIZE / 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  page_id_t first_page_id;
+  {
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  // Scenario: starting a scan prefetches the second page. The free space map took the page id after the first one,
+  // so the chain is not consecutive there and nothing beyond the link is guessed.
+  const uint32_t readahead_window = 8;
+  auto *bpm = new BufferPoolManager(20, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+  auto *first_page = static_cast<TablePage *>(bpm->FetchPage(first_page_id));
+  ASSERT_NE(nullptr, first_page);
+  const page_id_t second_page_id = first_page->GetNextPageId();
+  EXPECT_TRUE(bpm->UnpinPage(first_page_id, false));
+  ASSERT_NE(first_page_id + 1, second_page_id);
+  auto iter = table.Begin(txn, nullptr, readahead_window);
+  for (int i = 0; i < 500 && bpm->GetNumPrefetched() < 1; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(1, bpm->GetNumPrefetched());
+
+  // Scenario: on the second page, which links to the next page id, the scan prefetches the window behind it and then
+  // hits on it.
+  int count = 0;
+  for (; iter->GetRid().GetPageId() != second_page_id; ++iter) {
+    count++;
+  }
+  for (int i = 0; i < 500 && bpm->GetNumPrefetched() < 1 + readahead_window; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(1 + readahead_window, bpm->GetNumPrefetched());
+  int num_reads = disk_manager->GetNumReads();
+  for (page_id_t page_id = second_page_id + 1; page_id <= second_page_id + static_cast<page_id_t>(readahead_window);
+       page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  // Scenario: the scan with readahead sees every tuple in order.
+  for (; iter != table.End(); ++iter) {
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+
+  delete bpm;
+
+  // Scenario: pages that were never written are skipped, the others can be fetched without a read afterwards.
+  // Prefetches are handled in order, so once the last one is done the others have been dealt with.
+  bpm = new BufferPoolManager(5, disk_manager);
+  bpm->PrefetchPages({disk_manager->GetNumPages(), disk_manager->GetNumPages() + 1, first_page_id});
+  for (int i = 0; i < 500 && bpm->GetNumPrefetched() == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(1, bpm->GetNumPrefetched());
+  num_reads = disk_manager->GetNumReads();
+  ASSERT_NE(nullptr, bpm->FetchPage(first_page_id));
+  EXPECT_TRUE(bpm->UnpinPage(first_page_id, false));
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  // Scenario: prefetches only evict clean pages. The dirty ones stay resident, so nobody reads them back from disk
+  // before their write is done.
+  std::vector<page_id_t> dirty_page_ids;
+  for (int i = 0; i < 4; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "dirty %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    dirty_page_ids.emplace_back(page_id);
+  }
+  bpm->PrefetchPages({second_page_id, second_page_id + 1, second_page_id + 2});
+  for (int i = 0; i < 500 && bpm->GetNumPrefetched() < 4; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(4, bpm->GetNumPrefetched());
+  num_reads = disk_manager->GetNumReads();
+  for (auto page_id : dirty_page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("dirty " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+  delete bpm;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ScanWithReadaheadGapsTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  // About 20 pages per table, whatever the page size.
+  const int num_tuples = PAGE_SIZE / 8;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  page_id_t first_page_id;
+  {
+    // Two tables that grow side by side, so their pages take turns in the page ids.
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    TableHeap other_table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+      ASSERT_TRUE(other_table.InsertTuple(tuple, &rid, txn));
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  auto *bpm = new BufferPoolManager(100, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_ids.emplace_back(page_id);
+    auto *page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  for (size_t i = 1; i < page_ids.size(); i++) {
+    ASSERT_NE(page_ids[i - 1] + 1, page_ids[i]);
+  }
+  delete bpm;
+
+  // Scenario: a scan with readahead only prefetches the pages of the chain, never the pages of the other table that
+  // lie between them. Every page of the table is read once, by the prefetch or by the scan.
+  bpm = new BufferPoolManager(100, disk_manager);
+  TableHeap scanned_table(bpm, nullptr, nullptr, first_page_id);
+  const int num_reads = disk_manager->GetNumReads();
+  int count = 0;
+  for (auto iter = scanned_table.Begin(txn, nullptr, 8); iter != scanned_table.End(); ++iter) {
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  // Give the prefetch of a page beyond the chain, if one was asked for, the time to happen.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  delete bpm;
+  EXPECT_EQ(page_ids.size(), disk_manager->GetNumReads() - num_reads);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 500;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::REGULAR);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, txn);
+  const page_id_t first_page_id = table->GetFirstPageId();
+
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+  };
+  auto count_pages = [bpm, first_page_id]() {
+    size_t num_pages = 0;
+    for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID; num_pages++) {
+      auto *page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+      page_id_t next_page_id = page->GetNextPageId();
+      bpm->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    return num_pages;
+  };
+
+  // Scenario: the map tracks every page of the table.
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, txn));
+    rids.emplace_back(rid);
+  }
+  const size_t num_pages = count_pages();
+  EXPECT_LT(1, num_pages);
+  EXPECT_EQ(num_pages, table->GetFreeSpaceMap()->GetNumPages());
+  EXPECT_EQ(rids.back().GetPageId(), table->GetFreeSpaceMap()->GetLastPageId());
+
+  // Scenario: the space of deleted tuples is found and reused by later inserts, the table does not grow.
+  const page_id_t hole_page_id = rids[num_tuples / 2].GetPageId();
+  int num_deleted = 0;
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == hole_page_id) {
+      ASSERT_TRUE(table->MarkDelete(rid, txn));
+      table->ApplyDelete(rid, txn);
+      num_deleted++;
+    }
+  }
+  for (int i = 0; i < num_deleted; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(num_tuples + i), &rid, txn));
+    EXPECT_EQ(hole_page_id, rid.GetPageId());
+  }
+  EXPECT_EQ(num_pages, count_pages());
+
+  // Scenario: the map is persisted in pages and found again when the table is opened.
+  delete table;
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id);
+  EXPECT_EQ(num_pages, table->GetFreeSpaceMap()->GetNumPages());
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(0), &rid, txn));
+  EXPECT_EQ(num_pages, count_pages());
+
+  // Scenario: a table that has lost its map gets a new one built from its page chain.
+  delete table;
+  auto *first_page = static_cast<TablePage *>(bpm->FetchPage(first_page_id));
+  first_page->SetFreeSpaceMapPageId(INVALID_PAGE_ID);
+  bpm->UnpinPage(first_page_id, true);
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id);
+  EXPECT_EQ(num_pages, table->GetFreeSpaceMap()->GetNumPages());
+  EXPECT_EQ(rids.back().GetPageId(), table->GetFreeSpaceMap()->GetLastPageId());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete table;
+  delete txn;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 500;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::REGULAR);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, lock_manager, nullptr, txn);
+  const page_id_t first_page_id = table.GetFirstPageId();
+
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+  };
+  auto chain = [bpm, first_page_id]() {
+    std::vector<page_id_t> page_ids;
+    for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+      page_ids.emplace_back(page_id);
+      auto *page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+      page_id_t next_page_id = page->GetNextPageId();
+      bpm->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    return page_ids;
+  };
+  auto scan = [&table, &schema, txn]() {
+    std::vector<int> values;
+    for (auto iter = table.Begin(txn); iter != table.End(); ++iter) {
+      values.emplace_back(iter->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    return values;
+  };
+
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(make_tuple(i), &rid, txn));
+    rids.emplace_back(rid);
+  }
+  const std::vector<page_id_t> page_ids = chain();
+  ASSERT_LT(6, page_ids.size());
+
+  // Empty the pages of the middle third of the table, and delete every other tuple of the first page.
+  const std::set<page_id_t> emptied(page_ids.begin() + page_ids.size() / 3, page_ids.begin() + 2 * page_ids.size() / 3);
+  std::vector<int> expected;
+  for (int i = 0; i < num_tuples; i++) {
+    const bool on_first_page = rids[i].GetPageId() == first_page_id;
+    if (emptied.count(rids[i].GetPageId()) != 0 || (on_first_page && i % 2 == 0)) {
+      ASSERT_TRUE(table.MarkDelete(rids[i], txn));
+      table.ApplyDelete(rids[i], txn);
+    } else {
+      expected.emplace_back(i);
+    }
+  }
+
+  // A scan that is on the page before the emptied ones, and one that runs along.
+  auto iter = table.Begin(txn);
+  while (iter->GetRid().GetPageId() != page_ids[page_ids.size() / 3 - 1]) {
+    ++iter;
+  }
+  const int iter_value = iter->GetValue(&schema, 0).GetAs<int32_t>();
+  std::atomic<bool> done{false};
+  std::thread reader([&]() {
+    while (!done) {
+      EXPECT_EQ(expected, scan());
+    }
+  });
+
+  TableHeap::VacuumResult result = table.Vacuum();
+  done = true;
+  reader.join();
+  EXPECT_EQ(emptied.size(), result.freed_pages_);
+  EXPECT_LE(1, result.compacted_pages_);
+  EXPECT_LT(emptied.size() * PAGE_SIZE, result.reclaimed_bytes_);
+  const std::vector<page_id_t> vacuumed_page_ids = chain();
+  EXPECT_EQ(page_ids.size() - emptied.size(), vacuumed_page_ids.size());
+  for (page_id_t page_id : vacuumed_page_ids) {
+    EXPECT_EQ(0, emptied.count(page_id));
+  }
+  EXPECT_EQ(vacuumed_page_ids.size(), table.GetFreeSpaceMap()->GetNumPages());
+  EXPECT_EQ(expected, scan());
+
+  // The scan that was on its way goes on past the unlinked pages.
+  std::vector<int> rest;
+  for (; iter != table.End(); ++iter) {
+    rest.emplace_back(iter->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(std::vector<int>(std::find(expected.begin(), expected.end(), iter_value), expected.end()), rest);
+
+  // Inserts go to the reclaimed space, never to an unlinked page.
+  const int num_deleted = num_tuples - static_cast<int>(expected.size());
+  for (int i = 0; i < num_deleted; i++) {
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(make_tuple(num_tuples + i), &rid, txn));
+    EXPECT_EQ(0, emptied.count(rid.GetPageId()));
+  }
+
+  // The next vacuum deallocates the unlinked pages, so new pages reuse them.
+  result = table.Vacuum();
+  EXPECT_EQ(0, result.freed_pages_);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, emptied.count(page_id));
+  bpm->UnpinPage(page_id, false);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete txn;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 200;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::REGULAR);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, lock_manager, nullptr, txn);
+
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(
+        Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema),
+        &rid, txn));
+    rids.emplace_back(rid);
+  }
+  const page_id_t middle_page_id = rids[num_tuples / 2].GetPageId();
+  ASSERT_NE(middle_page_id, rids.front().GetPageId());
+  ASSERT_NE(middle_page_id, rids.back().GetPageId());
+
+  // A copy of an iterator on the middle page pins nothing, only its scan keeps the page from being deallocated.
+  auto iter = table.Begin(txn);
+  while (iter->GetRid().GetPageId() != middle_page_id) {
+    ++iter;
+  }
+  auto copy = iter;
+  const int copy_value = copy->GetValue(&schema, 0).GetAs<int32_t>();
+  while (iter != table.End()) {
+    ++iter;
+  }
+
+  std::vector<int> expected;
+  for (int i = 0; i < num_tuples; i++) {
+    if (rids[i].GetPageId() == middle_page_id) {
+      ASSERT_TRUE(table.MarkDelete(rids[i], txn));
+      table.ApplyDelete(rids[i], txn);
+    } else if (i > copy_value) {
+      expected.emplace_back(i);
+    }
+  }
+  EXPECT_EQ(1, table.Vacuum().freed_pages_);
+  table.Vacuum();
+
+  // The unlinked page is not reused while the scan goes on, so the copy still finds its way on.
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_NE(middle_page_id, page_id);
+  memset(page->GetData(), 0xff, PAGE_SIZE);
+  bpm->UnpinPage(page_id, true);
+  std::vector<int> rest;
+  for (++copy; copy != table.End(); ++copy) {
+    rest.emplace_back(copy->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(expected, rest);
+
+  // Once the scan has finished, the page is deallocated.
+  table.Vacuum();
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(middle_page_id, page_id);
+  bpm->UnpinPage(page_id, false);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete txn;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ZoneMapTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Column col3{"c", TypeId::BIGINT};
+  Schema schema{{col1, col2, col3}};
+  // About 45 pages, whatever the page size.
+  const int num_tuples = PAGE_SIZE / 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, txn);
+  const page_id_t first_page_id = table->GetFirstPageId();
+
+  // a ascends, c is null in every tenth tuple.
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x')),
+                  i % 10 == 0 ? ValueFactory::GetNullValueByType(TypeId::BIGINT) : ValueFactory::GetBigIntValue(i)},
+                 &schema);
+  };
+  auto at_least = [](int low) {
+    return ZoneMap::Predicate{0, [low](const ZoneMap::ColumnSummary &summary) {
+                                return summary.max_.CompareGreaterThanEquals(ValueFactory::GetIntegerValue(low)) ==
+                                       CmpBool::CmpTrue;
+                              }};
+  };
+  // Scans with the predicate, returns the number of tuples with a >= low and the number of the others.
+  auto scan = [table, txn, &schema](const ZoneMap::Predicate &predicate, int low) {
+    std::pair<int, int> counts{0, 0};
+    for (auto iter = table->Begin(txn, nullptr, 0, false, &predicate); iter != table->End(); ++iter) {
+      (iter->GetValue(&schema, 0).GetAs<int32_t>() >= low ? counts.first : counts.second)++;
+    }
+    return counts;
+  };
+
+  // The zone map is built from the first third, the inserts and the bulk insert after that maintain it.
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples * 2 / 3; i++) {
+    if (i == num_tuples / 3) {
+      table->CreateZoneMap(schema, txn);
+    }
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, txn));
+    rids.emplace_back(rid);
+  }
+  std::vector<Tuple> tuples;
+  for (int i = num_tuples * 2 / 3; i < num_tuples; i++) {
+    tuples.emplace_back(make_tuple(i));
+  }
+  ASSERT_TRUE(table->BulkInsert(tuples, &rids, txn));
+  ZoneMap *zone_map = table->GetZoneMap();
+  ASSERT_NE(nullptr, zone_map);
+  size_t tuples_per_page = 0;
+  for (const auto &rid : rids) {
+    tuples_per_page += rid.GetPageId() == first_page_id ? 1 : 0;
+  }
+  ASSERT_LT(1, tuples_per_page);
+
+  // Scenario: the summaries of a page cover its tuples, variable-length columns have none.
+  for (int i = 0; i < num_tuples; i++) {
+    ZoneMap::ColumnSummary summary;
+    ASSERT_TRUE(zone_map->GetSummary(rids[i].GetPageId(), 0, &summary));
+    EXPECT_EQ(CmpBool::CmpTrue, summary.min_.CompareLessThanEquals(ValueFactory::GetIntegerValue(i)));
+    EXPECT_EQ(CmpBool::CmpTrue, summary.max_.CompareGreaterThanEquals(ValueFactory::GetIntegerValue(i)));
+    ASSERT_TRUE(zone_map->GetSummary(rids[i].GetPageId(), 2, &summary));
+    if (i % 10 == 0) {
+      EXPECT_LT(0, summary.null_count_);
+    }
+  }
+  ZoneMap::ColumnSummary summary;
+  EXPECT_FALSE(zone_map->GetSummary(first_page_id, 1, &summary));
+
+  // Scenario: a scan for the top quarter skips the pages below it, only the page where it starts has other tuples.
+  auto counts = scan(at_least(num_tuples * 3 / 4), num_tuples * 3 / 4);
+  EXPECT_EQ(num_tuples - num_tuples * 3 / 4, counts.first);
+  EXPECT_GT(tuples_per_page, counts.second);
+  // A predicate that every page satisfies reads everything.
+  counts = scan(at_least(0), num_tuples * 3 / 4);
+  EXPECT_EQ(num_tuples, counts.first + counts.second);
+
+  // Scenario: an update widens the summary of its page, which the scan reads again.
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(2 * num_tuples), rids[1], txn));
+  counts = scan(at_least(2 * num_tuples), 2 * num_tuples);
+  EXPECT_EQ(1, counts.first);
+  EXPECT_GT(tuples_per_page, counts.second);
+
+  // Scenario: no page can match, the scan is done before it begins.
+  auto none = at_least(3 * num_tuples);
+  EXPECT_TRUE(table->Begin(txn, nullptr, 0, false, &none) == table->End());
+
+  // Scenario: the zone map lives in memory, the table opened again with its schema builds it from the pages. The scan
+  // for the updated tuple skips the same pages as before.
+  delete table;
+  bpm->FlushAllPages();
+  TableHeap reopened(bpm, nullptr, nullptr, first_page_id, schema, txn);
+  ASSERT_NE(nullptr, reopened.GetZoneMap());
+  auto updated = at_least(2 * num_tuples);
+  counts = {0, 0};
+  for (auto iter = reopened.Begin(txn, nullptr, 0, false, &updated); iter != reopened.End(); ++iter) {
+    (iter->GetValue(&schema, 0).GetAs<int32_t>() >= 2 * num_tuples ? counts.first : counts.second)++;
+  }
+  EXPECT_EQ(1, counts.first);
+  EXPECT_GT(tuples_per_page, counts.second);
+  EXPECT_TRUE(reopened.Begin(txn, nullptr, 0, false, &none) == reopened.End());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, BulkInsertTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(20, disk_manager);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, nullptr, nullptr, txn);
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 100, 'x'))}, &schema);
+  };
+
+  // A few regular inserts first, the bulk insert continues in the last page.
+  int num_tuples = 0;
+  for (; num_tuples < 10; num_tuples++) {
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(make_tuple(num_tuples), &rid, txn));
+  }
+  const size_t write_set_size = txn->GetWriteSet()->size();
+
+  // Scenario: batches of tuples are appended in order, to the pool's capacity several times over.
+  std::vector<RID> rids;
+  for (int batch = 0; batch < 20; batch++) {
+    std::vector<Tuple> tuples;
+    for (int i = 0; i < 500; i++) {
+      tuples.emplace_back(make_tuple(num_tuples++));
+    }
+    ASSERT_TRUE(table.BulkInsert(tuples, &rids, txn));
+  }
+  EXPECT_EQ(num_tuples - 10, rids.size());
+  EXPECT_EQ(write_set_size, txn->GetWriteSet()->size());
+  for (size_t i = 0; i < rids.size(); i += 97) {
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(rids[i], &tuple, txn));
+    EXPECT_EQ(static_cast<int>(i + 10), tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  int count = 0;
+  for (auto iter = table.Begin(txn); iter != table.End(); ++iter) {
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+
+  // Scenario: pages are packed, every page but the last one is left with less room than the largest tuple.
+  for (auto iter = rids.begin(); iter + 1 != rids.end(); ++iter) {
+    if (iter->GetPageId() == (iter + 1)->GetPageId()) {
+      continue;
+    }
+    auto *page = static_cast<TablePage *>(bpm->FetchPage(iter->GetPageId()));
+    EXPECT_LT(page->GetFreeSpaceRemaining(), make_tuple(99).GetLength() + TablePage::SIZE_TUPLE);
+    EXPECT_EQ((iter + 1)->GetPageId(), page->GetNextPageId());
+    bpm->UnpinPage(iter->GetPageId(), false);
+  }
+
+  // Scenario: the free space map knows the new pages, regular inserts go on after the bulk load.
+  EXPECT_EQ(rids.back().GetPageId(), table.GetFreeSpaceMap()->GetLastPageId());
+  RID rid;
+  ASSERT_TRUE(table.InsertTuple(make_tuple(num_tuples), &rid, txn));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ZeroCopyScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 500;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, nullptr, nullptr, txn);
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::to_string(i))}, &schema);
+    ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+  }
+
+  // Scenario: a zero-copy scan sees the same tuples as a copying scan, as views into the pages.
+  auto copy_iter = table.Begin(txn);
+  int count = 0;
+  for (auto iter = table.Begin(txn, nullptr, 0, true); iter != table.End(); ++iter, ++copy_iter) {
+    ASSERT_NE(table.End(), copy_iter);
+    EXPECT_TRUE(copy_iter->IsAllocated());
+    EXPECT_FALSE(iter->IsAllocated());
+    EXPECT_EQ(copy_iter->GetRid(), iter->GetRid());
+    EXPECT_EQ(copy_iter->ToString(&schema), iter->ToString(&schema));
+    EXPECT_EQ(count, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_EQ(table.End(), copy_iter);
+
+  // Scenario: a released iterator continues where it stopped, and a copy of it owns its tuple.
+  count = 0;
+  for (auto iter = table.Begin(txn, nullptr, 0, true); iter != table.End(); ++iter, count++) {
+    EXPECT_EQ(std::to_string(count), iter->GetValue(&schema, 1).ToString());
+    TableIterator copy(iter);
+    iter.Release();
+    EXPECT_TRUE(copy->IsAllocated());
+    EXPECT_EQ(std::to_string(count), copy->GetValue(&schema, 1).ToString());
+  }
+  EXPECT_EQ(num_tuples, count);
+
+  // Scenario: finished and released iterators hold no pages, so every page of the table can be deleted.
+  {
+    auto iter = table.Begin(txn, nullptr, 0, true);
+    iter.Release();
+  }
+  page_id_t page_id = table.GetFirstPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    EXPECT_TRUE(bpm->DeletePage(page_id));
+    page_id = next_page_id;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ManyOpenIteratorsTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  // About 45 pages, whatever the page size.
+  const int num_tuples = PAGE_SIZE / 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  page_id_t first_page_id;
+  {
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(150, 'x'))}, &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  // Scenario: more scans are open at once, each on a page of its own, than the pool has frames. A copying iterator
+  // holds no frame between increments, so they all go on to the end.
+  const size_t buffer_pool_size = 5;
+  const int num_iterators = 10;
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+  std::vector<TableIterator> iters;
+  std::vector<int> next_values;
+  for (int i = 0; i < num_iterators; i++) {
+    iters.emplace_back(table.Begin(txn));
+    next_values.emplace_back(0);
+    for (int j = 0; j < i * num_tuples / num_iterators; j++) {
+      ++iters.back();
+      next_values.back()++;
+    }
+  }
+  for (bool done = false; !done;) {
+    done = true;
+    for (int i = 0; i < num_iterators; i++) {
+      if (iters[i] == table.End()) {
+        continue;
+      }
+      done = false;
+      EXPECT_EQ(next_values[i], iters[i]->GetValue(&schema, 0).GetAs<int32_t>());
+      next_values[i]++;
+      ++iters[i];
+    }
+  }
+  for (int i = 0; i < num_iterators; i++) {
+    EXPECT_EQ(num_tuples, next_values[i]);
+  }
+  iters.clear();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete txn;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, OverflowTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 5 * PAGE_SIZE};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 20;
+  // Every other tuple is several pages large.
+  auto make_string = [](int i) {
+    return std::string(i % 2 == 0 ? 3 * PAGE_SIZE + i : 10, static_cast<char>('a' + i));
+  };
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *txn = new Transaction(0);
+  std::vector<RID> rids;
+  page_id_t first_page_id;
+  {
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(make_string(i))}, &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+      rids.emplace_back(rid);
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  TableHeap table(bpm, nullptr, nullptr, first_page_id);
+
+  // Scenario: a large tuple takes no more than one slot, and a zero-copy scan only reads its overflow pages for the
+  // large column.
+  Tuple tuple;
+  {
+    int num_reads = disk_manager->GetNumReads();
+    auto iter = table.Begin(txn, nullptr, 0, true);
+    EXPECT_EQ(rids[0], iter->GetRid());
+    EXPECT_EQ(0, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(num_reads + 1, disk_manager->GetNumReads());
+    EXPECT_EQ(make_string(0), iter->GetValue(&schema, 1).ToString());
+    EXPECT_LT(num_reads + 3, disk_manager->GetNumReads());
+  }
+
+  // Scenario: copying and zero-copy scans see the whole tuples.
+  for (bool zero_copy : {false, true}) {
+    int count = 0;
+    for (auto iter = table.Begin(txn, nullptr, 0, zero_copy); iter != table.End(); ++iter) {
+      int i = iter->GetValue(&schema, 0).GetAs<int32_t>();
+      EXPECT_EQ(rids[i], iter->GetRid());
+      EXPECT_EQ(make_string(i), iter->GetValue(&schema, 1).ToString());
+      count++;
+    }
+    EXPECT_EQ(num_tuples, count);
+  }
+
+  // Scenario: updates between small and large tuples replace the overflow pages, deletes free them.
+  const size_t pages_per_tuple = 3;
+  size_t num_free_pages = disk_manager->GetNumFreePages();
+  Tuple large({ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(make_string(0))}, &schema);
+  Tuple small({ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue(make_string(1))}, &schema);
+  ASSERT_TRUE(table.UpdateTuple(large, rids[1], txn));
+  ASSERT_TRUE(table.UpdateTuple(small, rids[0], txn));
+  ASSERT_TRUE(table.GetTuple(rids[1], &tuple, txn));
+  EXPECT_EQ(make_string(0), tuple.GetValue(&schema, 1).ToString());
+  ASSERT_TRUE(table.GetTuple(rids[0], &tuple, txn));
+  EXPECT_EQ(make_string(1), tuple.GetValue(&schema, 1).ToString());
+  EXPECT_EQ(num_free_pages + pages_per_tuple, disk_manager->GetNumFreePages());
+  // Keep the freed pages from being the last pages of the file, which are truncated instead.
+  while (disk_manager->GetNumFreePages() > 0) {
+    disk_manager->AllocatePage();
+  }
+  page_id_t guard_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&guard_page_id));
+  bpm->UnpinPage(guard_page_id, true);
+  for (int i = 1; i < num_tuples; i++) {
+    ASSERT_TRUE(table.MarkDelete(rids[i], txn));
+    table.ApplyDelete(rids[i], txn);
+  }
+  EXPECT_EQ(pages_per_tuple * (num_tuples / 2), disk_manager->GetNumFreePages());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete bpm;
+  delete txn;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, OverflowDeleteTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 5 * PAGE_SIZE};
+  Schema schema{{col1, col2}};
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i),
+                  ValueFactory::GetVarcharValue(std::string(3 * PAGE_SIZE, static_cast<char>('a' + i)))},
+                 &schema);
+  };
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *txn = new Transaction(0);
+  TableHeap table(bpm, nullptr, nullptr, txn);
+  RID rid;
+  ASSERT_TRUE(table.InsertTuple(make_tuple(0), &rid, txn));
+
+  // Tuples that were read before the delete: by GetTuple, by a copying scan, and copied from a zero-copy scan.
+  Tuple read;
+  ASSERT_TRUE(table.GetTuple(rid, &read, txn));
+  Tuple scanned = *table.Begin(txn);
+  Tuple copied = *table.Begin(txn, nullptr, 0, true);
+
+  // The delete frees the overflow pages, and the next large tuples take them over.
+  ASSERT_TRUE(table.MarkDelete(rid, txn));
+  table.ApplyDelete(rid, txn);
+  for (int i = 1; i < 4; i++) {
+    RID other_rid;
+    ASSERT_TRUE(table.InsertTuple(make_tuple(i), &other_rid, txn));
+  }
+  const std::string expected = make_tuple(0).GetValue(&schema, 1).ToString();
+  for (const Tuple *tuple : {&read, &scanned, &copied}) {
+    EXPECT_EQ(0, tuple->GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(expected, tuple->GetValue(&schema, 1).ToString());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete bpm;
+  delete txn;
+  delete disk_manager;
+}
+
+// Measures the insert throughput of a table growing to 1M rows. With the free space map, every insert fetches a
+// bounded number of pages, so the throughput stays flat as the table grows.
+// NOLINTNEXTLINE
+TEST(TableHeapTest, DISABLED_InsertBenchmark) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 1000000;
+  const int report_every = 100000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(1000, disk_manager);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, txn);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i)}, &schema);
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    // Keep the write set from growing without bounds, nothing commits here.
+    txn->GetWriteSet()->clear();
+    if ((i + 1) % report_every == 0) {
+      auto end = std::chrono::steady_clock::now();
+      double seconds = std::chrono::duration<double>(end - start).count();
+      std::cout << "rows " << i + 1 - report_every << ".." << i + 1 << ": " << static_cast<int>(report_every / seconds)
+                << " inserts/s" << std::endl;
+      start = end;
+    }
+  }
+  std::cout << "table pages: " << table->GetFreeSpaceMap()->GetNumPages() << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete table;
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures loading a table through BulkInsert, in batches like TableGenerator::FillTable.
+// NOLINTNEXTLINE
+TEST(TableHeapTest, DISABLED_BulkInsertBenchmark) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 10000000;
+  const int batch_size = 1024;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(1000, disk_manager);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, txn);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i)},
+                        &schema);
+    if (tuples.size() == batch_size || i + 1 == num_tuples) {
+      ASSERT_TRUE(table->BulkInsert(tuples, nullptr, txn));
+      tuples.clear();
+    }
+  }
+  bpm->FlushAllPages();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t num_pages = table->GetFreeSpaceMap()->GetNumPages();
+  std::cout << num_tuples << " rows in " << num_pages << " pages: " << static_cast<int>(num_tuples / seconds)
+            << " rows/s, " << static_cast<int>(num_pages * PAGE_SIZE / seconds / (1 << 20)) << " MiB/s" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete table;
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures scanning a 1M row table with a predicate on one column, copying every tuple and with zero-copy views.
+// NOLINTNEXTLINE
+TEST(TableHeapTest, DISABLED_ScanBenchmark) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 100};
+  Schema schema{{col1, col2}};
+  const int num_tuples = 1000000;
+  const int num_rounds = 5;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10000, disk_manager);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, txn);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("row")},
+                        &schema);
+    if (tuples.size() == 1024 || i + 1 == num_tuples) {
+      ASSERT_TRUE(table->BulkInsert(tuples, nullptr, txn));
+      tuples.clear();
+    }
+  }
+
+  for (bool zero_copy : {false, true}) {
+    auto start = std::chrono::steady_clock::now();
+    int matches = 0;
+    for (int round = 0; round < num_rounds; round++) {
+      for (auto iter = table->Begin(txn, nullptr, 0, zero_copy); iter != table->End(); ++iter) {
+        if (iter->GetValue(&schema, 0).GetAs<int32_t>() % 10 == 0) {
+          matches++;
+        }
+      }
+    }
+    ASSERT_EQ(num_rounds * num_tuples / 10, matches);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (zero_copy ? "zero-copy" : "copying")
+              << " scan: " << static_cast<int>(num_rounds * num_tuples / seconds) << " rows/s" << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete table;
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
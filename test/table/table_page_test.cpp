@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_page_test.cpp
+//
+// Identification: test/table/table_page_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/page/table_page.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TablePageTest, SlotReuseAndCompactionTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  Schema schema{{col1, col2}};
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 50, 'x'))}, &schema);
+  };
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  auto *txn = new Transaction(0);
+  page_id_t page_id;
+  auto *page = static_cast<TablePage *>(bpm->NewPage(&page_id));
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, txn);
+
+  // Fill the page.
+  std::vector<RID> rids;
+  for (int i = 0;; i++) {
+    RID rid;
+    if (!page->InsertTuple(make_tuple(i), &rid, txn, nullptr, nullptr)) {
+      break;
+    }
+    EXPECT_EQ(i, rid.GetSlotNum());
+    rids.emplace_back(rid);
+  }
+  const uint32_t full_free_space = page->GetFreeSpaceRemaining();
+
+  // Scenario: deleting tuples leaves their space for later, but it counts as free space right away.
+  uint32_t deleted_bytes = 0;
+  size_t num_deleted = 0;
+  for (size_t i = 1; i < rids.size(); i += 3) {
+    deleted_bytes += make_tuple(i).GetLength();
+    num_deleted++;
+    ASSERT_TRUE(page->MarkDelete(rids[i], txn, nullptr, nullptr));
+    page->ApplyDelete(rids[i], txn, nullptr);
+  }
+  EXPECT_EQ(full_free_space + deleted_bytes, page->GetFreeSpaceRemaining());
+
+  // Scenario: inserts reuse the freed slots, the last freed slot first, and compact the page once they need to.
+  for (size_t n = 0, i = rids.size() - 1; n < num_deleted; n++) {
+    while (i % 3 != 1) {
+      i--;
+    }
+    RID rid;
+    ASSERT_TRUE(page->InsertTuple(make_tuple(i), &rid, txn, nullptr, nullptr));
+    EXPECT_EQ(rids[i], rid);
+    i--;
+  }
+  EXPECT_EQ(full_free_space, page->GetFreeSpaceRemaining());
+
+  // Every tuple reads back intact after the compaction.
+  for (size_t i = 0; i < rids.size(); i++) {
+    Tuple tuple;
+    ASSERT_TRUE(page->GetTuple(rids[i], &tuple, txn, nullptr));
+    EXPECT_EQ(static_cast<int>(i), tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(std::string(i % 50, 'x'), tuple.GetValue(&schema, 1).ToString());
+  }
+
+  // Scenario: an update that grows a tuple uses the dead space too.
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    ASSERT_TRUE(page->MarkDelete(rids[i], txn, nullptr, nullptr));
+    page->ApplyDelete(rids[i], txn, nullptr);
+  }
+  Tuple old_tuple;
+  Column col3{"c", TypeId::VARCHAR, 2000};
+  Schema big_schema{{col1, col3}};
+  Tuple big_tuple({ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(std::string(1500, 'y'))},
+                  &big_schema);
+  ASSERT_TRUE(page->UpdateTuple(big_tuple, &old_tuple, rids[1], txn, nullptr, nullptr));
+  Tuple tuple;
+  ASSERT_TRUE(page->GetTuple(rids[1], &tuple, txn, nullptr));
+  EXPECT_EQ(std::string(1500, 'y'), tuple.GetValue(&big_schema, 1).ToString());
+  ASSERT_TRUE(page->GetTuple(rids[3], &tuple, txn, nullptr));
+  EXPECT_EQ(3, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+
+  bpm->UnpinPage(page_id, true);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures inserts into a page with many slots, deleting and reinserting one tuple at a time.
+// NOLINTNEXTLINE
+TEST(TablePageTest, DISABLED_SlotReuseBenchmark) {
+  Column col1{"a", TypeId::INTEGER};
+  Schema schema{{col1}};
+  Tuple tuple({ValueFactory::GetIntegerValue(0)}, &schema);
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  auto *txn = new Transaction(0);
+  page_id_t page_id;
+  auto *page = static_cast<TablePage *>(bpm->NewPage(&page_id));
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, txn);
+  std::vector<RID> rids;
+  RID rid;
+  while (page->InsertTuple(tuple, &rid, txn, nullptr, nullptr)) {
+    rids.emplace_back(rid);
+  }
+
+  const int rounds = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    // Delete a tuple near the end of the slot array, a linear slot search would walk nearly all of it.
+    rid = rids[rids.size() - 1 - i % 16];
+    page->MarkDelete(rid, txn, nullptr, nullptr);
+    page->ApplyDelete(rid, txn, nullptr);
+    page->InsertTuple(tuple, &rid, txn, nullptr, nullptr);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << rids.size() << " slots: " << static_cast<int>(rounds / seconds) << " delete+insert/s" << std::endl;
+
+  bpm->UnpinPage(page_id, true);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub